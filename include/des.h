@@ -0,0 +1,62 @@
+#ifndef DES_H
+#define DES_H
+
+#include "patient.h"
+#include "scheduler.h"
+#include "resources.h"
+#include "logring.h"
+
+// Discrete-event simulation of a scheduler run.
+// Replays the same dispatch as the threaded mode (patients released in
+// scheduled order, each stage of a pathway holding one unit of its resource
+// for the stage's duration) on a virtual clock, so a whole day runs in
+// milliseconds. Patients waiting for a busy resource are granted units in
+// scheduled order; a patient that finishes a stage joins the next stage's
+// queue at once, so doctors, machines and rooms work on different patients
+// concurrently.
+
+typedef enum {
+    DES_RELEASE_ORDER = 0,   // patient k is released at k * launch_gap_ms (mirrors the thread launcher)
+    DES_RELEASE_ARRIVAL = 1  // patient is released at its arrival_ms
+} DesRelease;
+
+typedef struct {
+    DesRelease release;
+    unsigned launch_gap_ms;  // spacing between releases for DES_RELEASE_ORDER
+    unsigned quantum_ms;     // > 0: units are time-sliced Round Robin among their waiters
+} DesConfig;
+
+// The chain that ends the makespan: the last patient to finish, with the
+// time it queued before each stage
+typedef struct {
+    int k;                               // scheduled position, -1 if nothing ran
+    int patient_id;
+    unsigned long long release_ms;
+    int steps;
+    PathStep path[MAX_PATH_STEPS];
+    unsigned long long wait_ms[MAX_PATH_STEPS];
+} DesCriticalPath;
+
+typedef struct {
+    ScheduleMetrics observed;        // wait/turnaround measured from release, including resource contention
+    unsigned long long makespan_ms;  // virtual time of the last FINISH
+    double stage_wait_ms[RESOURCE_TYPE_COUNT];  // mean queue time per stage, by resource
+    DesCriticalPath critical;
+} DesResult;
+
+void des_default_config(DesConfig *cfg);
+
+// Runs the simulation over `order` (positions into src, which may be a
+// mapped snapshot's rows), using rp's capacities and accumulating
+// busy, wait and concurrency totals into rp->acct. START/FINISH records go to log (skipped if NULL).
+// Returns 0 on success, -1 on allocation failure.
+int des_run(const PatientSource *src, const int *order, ResourcePool *rp,
+            const DesConfig *cfg, LogRing *log, DesResult *out);
+
+// As des_run, also storing each patient's wait (turnaround minus service) in
+// wait_out[k] for scheduled position k. wait_out may be NULL.
+int des_run_detailed(const PatientSource *src, const int *order, ResourcePool *rp,
+                     const DesConfig *cfg, LogRing *log, DesResult *out,
+                     unsigned long long *wait_out);
+
+#endif // DES_H
@@ -0,0 +1,66 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include "patient.h"
+#include "scheduler.h"
+
+// Event-driven single-server dispatch engine.
+// Unlike the static sorts in schedule_order(), the ready queue only ever holds
+// patients that have already arrived. The ready queue is a binary heap keyed by
+// the algorithm (arrival, burst, priority or remaining time), so a run over n
+// patients costs O(n log n) including preemptions (at most one per arrival).
+//
+// Arrivals are fed in non-decreasing arrival_ms order; dispatch decisions at a
+// time t are deferred until every arrival at t has been seen.
+
+typedef struct {
+    int idx;                  // caller's patient index (or sequence number)
+    int id;                   // patient id, for callers without an index to look it up
+    unsigned arrival_ms;
+    unsigned burst_ms;
+    unsigned remaining_ms;
+    int priority;
+} DispatchJob;
+
+typedef struct {
+    // First time a job gets the server
+    void (*on_start)(void *ctx, const DispatchJob *job, unsigned long long t);
+    // A contiguous run [start, end) of a job, emitted when it is preempted or finishes
+    void (*on_slice)(void *ctx, const DispatchJob *job, unsigned long long start, unsigned long long end);
+    void (*on_finish)(void *ctx, const DispatchJob *job, unsigned long long t);
+    void *ctx;
+} DispatchHooks;
+
+typedef struct {
+    Algorithm alg;
+    DispatchHooks hooks;
+    DispatchJob *heap;          // ready queue
+    size_t count, cap;
+    int running;                // 1 while `current` holds the server
+    DispatchJob current;
+    unsigned long long slice_start;
+    unsigned long long now;
+} Dispatcher;
+
+// Returns 1 for algorithms this engine implements (all but Round Robin).
+int dispatch_supports(Algorithm alg);
+// Returns 1 for algorithms that may preempt the running job.
+int dispatch_is_preemptive(Algorithm alg);
+
+int dispatcher_init(Dispatcher *d, Algorithm alg, const DispatchHooks *hooks);
+void dispatcher_destroy(Dispatcher *d);
+
+// Start the clock at `now` instead of 0. Call before the first arrival; used
+// to resume a schedule after a prefix that is already known.
+void dispatcher_start_at(Dispatcher *d, unsigned long long now);
+
+// Feed one arrival. Jobs must come in non-decreasing arrival_ms. Returns -1 on allocation failure.
+int dispatcher_arrive(Dispatcher *d, const DispatchJob *job);
+// Run until the ready queue is empty and the server is idle.
+void dispatcher_drain(Dispatcher *d);
+
+// Runs a whole PatientList through the engine, calling hooks with idx = patient index.
+int dispatch_run_list(const PatientList *list, Algorithm alg, const DispatchHooks *hooks);
+int dispatch_run_columns(const PatientColumns *cols, Algorithm alg, const DispatchHooks *hooks);
+
+#endif // DISPATCH_H
@@ -0,0 +1,86 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+// HDR-style log-linear latency histogram (milliseconds).
+// Values below HIST_SUB are counted exactly. Above that, every power of two
+// [2^m, 2^(m+1)) is split into HIST_SUB equal sub-buckets, so a bucket is at
+// most 1/HIST_SUB of its lower bound wide (12.5%). Buckets cover everything
+// below 2^HIST_MAGNITUDES ms; larger values land in the last bucket. Recording
+// is a count-leading-zeros, a shift and an increment; merging is one add per
+// bucket, so per-thread histograms combine cheaply.
+
+#define HIST_SUB_BITS 3
+#define HIST_SUB (1u << HIST_SUB_BITS)
+#define HIST_MAGNITUDES 40
+#define HIST_BUCKETS ((HIST_MAGNITUDES - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} Histogram;
+
+static inline unsigned hist_bucket(uint64_t v) {
+    if (v < HIST_SUB) return (unsigned)v;
+    unsigned m = 63u - (unsigned)__builtin_clzll(v);     // v in [2^m, 2^(m+1))
+    if (m >= HIST_MAGNITUDES) return HIST_BUCKETS - 1;
+    unsigned sub = (unsigned)(v >> (m - HIST_SUB_BITS)) - HIST_SUB;
+    return (m - HIST_SUB_BITS + 1) * HIST_SUB + sub;
+}
+
+// Smallest value that lands in bucket b
+static inline uint64_t hist_bucket_low(unsigned b) {
+    if (b < HIST_SUB) return b;
+    unsigned m = b / HIST_SUB + HIST_SUB_BITS - 1;
+    return (uint64_t)(HIST_SUB + b % HIST_SUB) << (m - HIST_SUB_BITS);
+}
+
+// Largest value that lands in bucket b
+static inline uint64_t hist_bucket_high(unsigned b) {
+    return b + 1 < HIST_BUCKETS ? hist_bucket_low(b + 1) - 1 : UINT64_MAX;
+}
+
+// Count v, whose bucket b = hist_bucket(v) the caller already has (lets one
+// value go into several histograms for a single bucket computation)
+static inline void hist_record_in(Histogram *h, unsigned b, uint64_t v) {
+    h->counts[b]++;
+    h->total++;
+    if (v > h->max) h->max = v;
+}
+
+// Undo one hist_record_in. max is left as is; a caller that removes the
+// maximum recomputes it from its own data.
+static inline void hist_remove_in(Histogram *h, unsigned b) {
+    h->counts[b]--;
+    h->total--;
+}
+
+static inline void hist_record(Histogram *h, uint64_t v) {
+    hist_record_in(h, hist_bucket(v), v);
+}
+
+static inline void hist_merge(Histogram *dst, const Histogram *src) {
+    for (unsigned b = 0; b < HIST_BUCKETS; ++b) dst->counts[b] += src->counts[b];
+    dst->total += src->total;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+// Upper bound of the bucket holding the p-quantile (0 < p <= 1), capped at max.
+static inline uint64_t hist_percentile(const Histogram *h, double p) {
+    if (h->total == 0) return 0;
+    uint64_t rank = (uint64_t)(p * (double)h->total + 0.999999);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < HIST_BUCKETS; ++b) {
+        seen += h->counts[b];
+        if (seen >= rank) {
+            uint64_t high = hist_bucket_high(b);
+            return high < h->max ? high : h->max;
+        }
+    }
+    return h->max;
+}
+
+#endif // HISTOGRAM_H
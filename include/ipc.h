@@ -10,18 +10,44 @@
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <stdatomic.h>
+#include "logfmt.h"
+#include "histogram.h"
 
 #define FIFO_PATH "/tmp/hospital_log_fifo"
 #define MQ_NAME "/hospital_log_mq"
 #define SHM_NAME "/hospital_stats"
+#define SHM_LOG_NAME "/hospital_log_ring"
+
+// Records in the shared-memory log ring (power of two; 1 MiB of records)
+#define SHM_LOG_CAPACITY 65536
+// A full ring whose consumer frees nothing for this long is abandoned
+#define SHM_LOG_STALL_MS 5000
 
 // Messages placed on the MQ
 #define MQ_MSG_MAX 256
 
+// Contents of the stats page. Refreshed continuously during a run by a single
+// publisher thread (see livestats.h).
 typedef struct {
-    double avg_wait_ms;
+    double avg_wait_ms;          // scheduler's predicted averages
     double avg_turnaround_ms;
     int completed_jobs;
+    int total_jobs;
+    int running;                 // 0 once the run has finished
+    uint64_t elapsed_ms;         // since the run started (monotonic)
+    uint32_t in_flight[RESOURCE_TYPE_COUNT];     // patients holding a unit
+    uint32_t queue_depth[RESOURCE_TYPE_COUNT];   // patients waiting for a unit
+    uint64_t busy_ms[RESOURCE_TYPE_COUNT];       // doctor/machine/room busy time
+    Histogram wait_ms;           // observed time from START to acquiring a unit
+    Histogram turnaround_ms;     // observed time from START to FINISH
+} SharedStatsData;
+
+// Seqlock-protected page: seq is odd while the publisher writes. Readers
+// never block the publisher; they retry if seq changed under them.
+typedef struct {
+    _Atomic uint32_t seq;
+    SharedStatsData data;
 } SharedStats;
 
 int ipc_setup_fifo();
@@ -29,8 +55,42 @@ int ipc_cleanup_fifo();
 
 mqd_t ipc_open_mq(int create);
 int ipc_close_mq(mqd_t mq);
+int ipc_cleanup_mq();
 
 int ipc_setup_shm(int *fd, SharedStats **stats_ptr, int create);
 int ipc_cleanup_shm();
 
+// Single-writer seqlock publish, and a consistent snapshot for any reader.
+void shared_stats_write(SharedStats *stats, const SharedStatsData *data);
+void shared_stats_read(const SharedStats *stats, SharedStatsData *out);
+
+// Shared-memory log transport: a single-producer/single-consumer ring of
+// LogRecords. The scheduler's log flusher appends; the logger writes straight
+// from the mapping to disk and sleeps on a futex while the ring is empty.
+typedef struct {
+    _Alignas(64) _Atomic uint64_t head;   // next record to consume (logger)
+    _Alignas(64) _Atomic uint64_t tail;   // next record to produce (flusher)
+    _Atomic uint32_t futex;               // bumped after every publish
+    _Atomic uint32_t waiting;             // logger is about to sleep on futex
+    _Atomic uint32_t closed;              // producer is done
+    _Atomic uint32_t abandoned;           // producer gave up on the consumer
+    _Atomic int32_t consumer_pid;         // logger, once attached (0 before)
+    uint32_t capacity;                    // SHM_LOG_CAPACITY
+    _Alignas(64) LogRecord records[SHM_LOG_CAPACITY];
+} ShmLogRing;
+
+int ipc_setup_log_ring(int *fd, ShmLogRing **ring_ptr, int create);
+void ipc_close_log_ring(int fd, ShmLogRing *ring);
+int ipc_cleanup_log_ring();
+
+// Producer: append n records, waiting while the ring is full. If the
+// consumer has exited, or frees no space for SHM_LOG_STALL_MS, the ring is
+// abandoned: this and every later write drops its records and returns -1.
+int shm_log_write(ShmLogRing *ring, const LogRecord *recs, size_t n);
+// Producer: no more records will follow; wakes the logger.
+void shm_log_close(ShmLogRing *ring);
+// Consumer: sleep until more than `have` records are available, the ring is
+// closed or timeout_ms passes. Returns the number of records available.
+size_t shm_log_wait(ShmLogRing *ring, size_t have, unsigned timeout_ms);
+
 #endif // IPC_H
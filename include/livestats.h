@@ -0,0 +1,59 @@
+#ifndef LIVESTATS_H
+#define LIVESTATS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "ipc.h"
+#include "scheduler.h"
+
+// Live run statistics.
+// Workers (and the DES loop) bump process-local atomic counters on every
+// queue/acquire/release; a single publisher thread snapshots them every
+// period_ms into the shared stats page under its seqlock. Workers never touch
+// the page or take a lock, and monitors can poll the page as often as they like.
+
+typedef struct {
+    _Atomic uint64_t completed;
+    _Atomic uint32_t in_flight[RESOURCE_TYPE_COUNT];
+    _Atomic uint32_t queue_depth[RESOURCE_TYPE_COUNT];
+    _Atomic uint64_t busy_ms[RESOURCE_TYPE_COUNT];
+    _Atomic uint64_t wait_hist[HIST_BUCKETS];
+    _Atomic uint64_t turn_hist[HIST_BUCKETS];
+    _Atomic uint64_t wait_max, turn_max;
+
+    SharedStats *page;           // NULL: counters only, nothing published
+    SharedStatsData base;        // predicted averages and job total
+    uint64_t start_ns;
+    unsigned period_ms;
+    atomic_int stop;
+    int publishing;
+    pthread_t publisher;
+} LiveStats;
+
+#define LIVE_STATS_PERIOD_MS 10
+
+// Reset the counters and, if page is set, publish to it every period_ms.
+// predicted (may be NULL) fills the page's average fields.
+// Returns 0 on success, -1 if the publisher thread could not start.
+int live_stats_init(LiveStats *ls, SharedStats *page, const ScheduleMetrics *predicted,
+                    int total_jobs, unsigned period_ms);
+
+// Stop the publisher and write the final snapshot (running = 0).
+void live_stats_destroy(LiveStats *ls);
+
+// Snapshot the counters (what the publisher writes to the page).
+void live_stats_snapshot(LiveStats *ls, SharedStatsData *out);
+
+// Event hooks, called by whoever drives the resources. All lock-free.
+void live_stats_queued(LiveStats *ls, ResourceType r);
+void live_stats_acquired(LiveStats *ls, ResourceType r, uint64_t wait_ms);
+// Time-sliced service: the unit is handed back mid-service / taken again
+void live_stats_preempted(LiveStats *ls, ResourceType r);
+void live_stats_resumed(LiveStats *ls, ResourceType r);
+// The patient gave up waiting (the units could not be acquired): off the queue, unserved
+void live_stats_abandoned(LiveStats *ls, ResourceType r);
+// A non-final stage of a pathway is done; the patient moves on to the next queue
+void live_stats_stage_done(LiveStats *ls, ResourceType r, uint64_t busy_ms);
+void live_stats_released(LiveStats *ls, ResourceType r, uint64_t busy_ms, uint64_t turnaround_ms);
+
+#endif // LIVESTATS_H
@@ -0,0 +1,95 @@
+#ifndef LOGFMT_H
+#define LOGFMT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "patient.h"
+
+// Binary patient-event log.
+// The scheduler sends fixed 16-byte records over the log transport and the
+// logger appends them unchanged to LOG_BIN_PATH. Each run starts with a
+// LOG_EVENT_RUN record; bin/logdump turns the file back into text or CSV.
+// Records are in host byte order.
+
+#define LOG_BIN_PATH "logs/log.bin"
+#define LOG_FORMAT_VERSION 1
+
+typedef enum {
+    LOG_EVENT_START = 0,
+    LOG_EVENT_FINISH = 1,
+    LOG_EVENT_RUN = 2        // run header: patient_id = format version, resource = LogClock
+} LogEvent;
+
+typedef enum {
+    LOG_CLOCK_MONOTONIC = 0, // CLOCK_MONOTONIC nanoseconds (threaded runs)
+    LOG_CLOCK_VIRTUAL = 1    // simulated time in nanoseconds (DES runs)
+} LogClock;
+
+typedef struct {
+    uint64_t ts_ns;          // event time; for LOG_EVENT_RUN, the run's time base
+    int32_t patient_id;
+    uint8_t event;           // LogEvent
+    uint8_t service;         // ServiceType of the stage: first for START, last for FINISH
+    uint8_t resource;        // ResourceType
+    uint8_t reserved;
+} LogRecord;
+
+_Static_assert(sizeof(LogRecord) == 16, "LogRecord must stay 16 bytes");
+
+static inline const char *log_event_name(unsigned e) {
+    switch (e) {
+        case LOG_EVENT_START: return "START";
+        case LOG_EVENT_FINISH: return "FINISH";
+        case LOG_EVENT_RUN: return "RUN";
+        default: return "UNKNOWN";
+    }
+}
+
+static inline const char *log_service_name(unsigned s) {
+    switch (s) {
+        case SERVICE_CONSULTATION: return "Consultation";
+        case SERVICE_LAB_TEST: return "LabTest";
+        case SERVICE_TREATMENT: return "Treatment";
+        default: return "Unknown";
+    }
+}
+
+static inline const char *log_resource_name(unsigned r) {
+    switch (r) {
+        case RESOURCE_DOCTOR: return "doctor";
+        case RESOURCE_MACHINE: return "machine";
+        case RESOURCE_ROOM: return "room";
+        default: return "unknown";
+    }
+}
+
+// Decoding state for a stream of records: each LOG_EVENT_RUN record starts a
+// new run and sets the time base of the events after it.
+typedef struct {
+    int run;
+    uint64_t base;
+    int virtual_clock;
+} LogDecoder;
+
+// Describe r in one line (CSV row with csv set), relative to its run's time
+// base. Returns 1 for a run header, which has no CSV row, and 0 for an event.
+static inline int log_format_record(LogDecoder *d, const LogRecord *r, int csv, char *buf, size_t size) {
+    if (r->event == LOG_EVENT_RUN) {
+        d->run++;
+        d->base = r->ts_ns;
+        d->virtual_clock = r->resource == LOG_CLOCK_VIRTUAL;
+        snprintf(buf, size, "RUN %d version=%d clock=%s", d->run, r->patient_id,
+                 d->virtual_clock ? "virtual" : "monotonic");
+        return 1;
+    }
+    double t_ms = (double)(r->ts_ns - d->base) / 1e6;
+    if (csv)
+        snprintf(buf, size, "%d,%.3f,%s,%d,%s,%s", d->run, t_ms, log_event_name(r->event), r->patient_id,
+                 log_service_name(r->service), log_resource_name(r->resource));
+    else
+        snprintf(buf, size, "[%12.3f ms] %s id=%d service=%s resource=%s", t_ms, log_event_name(r->event),
+                 r->patient_id, log_service_name(r->service), log_resource_name(r->resource));
+    return 0;
+}
+
+#endif // LOGFMT_H
@@ -0,0 +1,59 @@
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "patient.h"
+#include "logfmt.h"
+#include "ipc.h"
+
+// Batched START/FINISH logging.
+// Producers (worker threads, the DES loop) publish fixed-size LogRecords into
+// a bounded lock-free MPSC ring: one fetch_add to claim a slot, a few plain
+// stores, one release store to publish. A single flusher thread drains the
+// ring in batches and hands each batch to the transport in one piece (one
+// write() on the FIFO, one copy into the shared-memory ring), so the
+// transport sees one writer and records never interleave.
+
+// Where the flusher sends records: the shared-memory ring when shm is set,
+// otherwise fd (the FIFO).
+typedef struct {
+    int fd;
+    ShmLogRing *shm;
+} LogTransport;
+
+typedef struct {
+    _Atomic size_t seq;         // == position when free, position + 1 when published
+    LogRecord rec;
+} LogSlot;
+
+#define LOG_RING_DEFAULT_CAP 4096
+#define LOG_RING_BATCH 256      // records per write()
+
+typedef struct {
+    LogSlot *slots;
+    size_t mask;                // capacity - 1 (capacity is a power of two)
+    _Atomic size_t tail;        // next position to claim (producers)
+    size_t head;                // next position to drain (flusher only)
+    LogTransport out;
+    atomic_int stop;
+    pthread_t flusher;
+} LogRing;
+
+// Allocate a ring of at least `capacity` slots (rounded up to a power of two),
+// send the LOG_EVENT_RUN header for `clock` and start the flusher writing to
+// `out`. Returns 0 on success, -1 on failure.
+int log_ring_init(LogRing *ring, const LogTransport *out, size_t capacity, LogClock clock);
+
+// Drain every published record, stop the flusher and free the ring.
+// The transport is left open (and a shm ring is not closed).
+void log_ring_destroy(LogRing *ring);
+
+// Publish one record for patient_id at service (and the resource it uses),
+// stamped with CLOCK_MONOTONIC. Blocks (yielding) only while the ring is full.
+void log_ring_push(LogRing *ring, LogEvent event, int patient_id, ServiceType service);
+// Same with a caller-supplied timestamp (virtual time for the DES engine).
+void log_ring_push_at(LogRing *ring, LogEvent event, int patient_id, ServiceType service,
+                      uint64_t ts_ns);
+
+#endif // LOGRING_H
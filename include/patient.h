@@ -9,21 +9,117 @@ typedef enum {
     SERVICE_TREATMENT = 2
 } ServiceType;
 
+#define SERVICE_TYPE_COUNT 3
+
+// Resource class a service occupies
+typedef enum {
+    RESOURCE_DOCTOR = 0,
+    RESOURCE_MACHINE = 1,
+    RESOURCE_ROOM = 2
+} ResourceType;
+
+#define RESOURCE_TYPE_COUNT 3
+
+static inline ResourceType resource_type_for_service(ServiceType s) {
+    switch (s) {
+        case SERVICE_CONSULTATION: return RESOURCE_DOCTOR;
+        case SERVICE_LAB_TEST: return RESOURCE_MACHINE;
+        default: return RESOURCE_ROOM;
+    }
+}
+
+#define MAX_PATH_STEPS 4
+
+// One stage of a visit: a service and how long it occupies its resource
+typedef struct {
+    unsigned char service;      // ServiceType
+    unsigned char extra;        // other resource types held for the stage (bit per ResourceType)
+    unsigned duration_ms;
+} PathStep;
+
 typedef struct {
     int id;
     char name[MAX_NAME_LEN];
     int priority;               // lower value == higher priority (1 highest)
-    ServiceType service;
-    unsigned required_time_ms;  // CPU burst time equivalent
+    ServiceType service;        // first stage's service
+    unsigned required_time_ms;  // CPU burst time equivalent: sum of all stage durations
     unsigned arrival_ms;        // arrival time in ms
+    unsigned char path_len;     // 0 = single stage (service, required_time_ms)
+    PathStep path[MAX_PATH_STEPS];
 } Patient;
 
+// The stages p goes through, in order. Returns the count (>= 1).
+static inline int patient_path(const Patient *p, PathStep *out) {
+    if (p->path_len == 0) {
+        out[0].service = (unsigned char)p->service;
+        out[0].extra = 0;
+        out[0].duration_ms = p->required_time_ms;
+        return 1;
+    }
+    for (int s = 0; s < p->path_len; ++s) out[s] = p->path[s];
+    return p->path_len;
+}
+
 typedef struct {
     Patient *items;
     size_t count;
 } PatientList;
 
+// Structure-of-arrays view of a PatientList for the scheduling hot loops.
+// Each numeric field is its own dense array, so a pass over arrivals or bursts
+// streams 4 bytes per patient instead of the whole 120-byte Patient. Ids and
+// names are cold: they are only filled when requested, names packed into one
+// string table and referenced by offset.
+typedef struct {
+    size_t count;
+    unsigned *arrival_ms;
+    unsigned *burst_ms;         // required_time_ms
+    int *priority;
+    unsigned char *service;     // ServiceType
+    int *id;                    // NULL unless built with PATIENT_COLS_NAMES
+    uint32_t *name_off;         // offsets into names, NULL unless built with PATIENT_COLS_NAMES
+    char *names;
+} PatientColumns;
+
+#define PATIENT_COLS_NAMES 1    // also gather ids and intern names
+
+// Patients read one at a time, either straight from rows or rebuilt on demand
+// by read(ctx, i, out) (e.g. from a mapped snapshot), so an engine that walks
+// patients does not need a materialized PatientList.
+typedef struct {
+    size_t count;
+    const Patient *rows;        // read in place when set
+    const void *ctx;
+    void (*read)(const void *ctx, size_t i, Patient *out);
+} PatientSource;
+
+PatientSource patient_list_source(const PatientList *list);
+
+// Patient i: a pointer into rows, or *tmp filled by read().
+static inline const Patient *patient_source_at(const PatientSource *src, size_t i, Patient *tmp) {
+    if (src->rows) return &src->rows[i];
+    src->read(src->ctx, i, tmp);
+    return tmp;
+}
+
+// n patients from the default workload mix with a fresh seed (see workload.h)
 PatientList create_patients(size_t n);
 void free_patients(PatientList *list);
 
+// Give p the stages steps[0..n): service becomes the first stage's and
+// required_time_ms their total. Returns 0, or -1 (p untouched) if n is not
+// 1..MAX_PATH_STEPS or the total does not fit in an unsigned.
+int patient_set_path(Patient *p, const PathStep *steps, int n);
+
+// Turn every patient into a full visit: consultation, lab test, treatment,
+// splitting its required time 30/40/30.
+void patients_apply_standard_pathway(PatientList *list);
+
+// Gather list into columns. flags: 0 or PATIENT_COLS_NAMES. Returns 0 or -1.
+int patient_columns_build(const PatientList *list, PatientColumns *cols, int flags);
+void patient_columns_free(PatientColumns *cols);
+
+// Name of patient i, or "" when names were not gathered.
+const char *patient_columns_name(const PatientColumns *cols, size_t i);
+
 #endif // PATIENT_H
@@ -2,25 +2,121 @@
 #define RESOURCES_H
 
 #include <pthread.h>
-#include <semaphore.h>
+#include <stdatomic.h>
 #include "patient.h"
+#include "livestats.h"
 
+// One stretch of service on a unit (ms since the pool was created, or
+// virtual ms for the DES)
+typedef struct {
+    int patient_id;
+    uint64_t start_ms;
+    uint64_t end_ms;
+} UnitInterval;
+
+typedef struct {
+    UnitInterval *items;
+    size_t count;
+    size_t cap;
+} UnitTimeline;
+
+// Busy time of one unit, on its own cache line
+typedef struct {
+    _Alignas(64) _Atomic uint64_t busy_ms;
+    _Atomic uint64_t served;
+    UnitTimeline timeline;      // guarded by the pool lock
+} UnitCounter;
+
+struct ResourceWaiter;
+
+// One resource type: individual units on a free list, plus counters.
+// The counters are atomics so readers never take the pool lock.
+typedef struct {
+    int *free_units;                     // stack of idle unit ids (pool lock)
+    int free_count;
+
+    _Alignas(64) _Atomic uint64_t busy_ms;   // total service time
+    _Atomic uint64_t wait_ms;                // total time spent waiting for a unit
+    _Atomic uint64_t served;
+    _Atomic int in_use;                      // units held right now
+    _Atomic int max_in_use;                  // high-water mark of in_use
+    UnitCounter *units;                      // [count]
+    int count;
+} ResourceAccount;
+
+// Set of resource types wanted together, one unit each
+typedef unsigned ResourceMask;
+#define RESOURCE_MASK(t) (1u << (t))
+
+// A waiter passed over by this many later-ranked grants stops being
+// backfilled around: one unit of each type it needs is reserved for it.
+#define RESOURCE_AGING_LIMIT 8
+
+// Grants are all-or-nothing: a caller needing a room AND a doctor takes both
+// at once or waits holding neither, so nested waits cannot deadlock or keep
+// a unit idle. Blocked callers sit in one ready queue ordered by scheduler
+// rank. On every release the queue is walked in rank order and each waiter
+// whose units are all free is granted (backfilling), so a patient waiting
+// for a scarce machine does not block one who only needs a free doctor.
+// Aging bounds how long a multi-unit request can be overtaken.
 typedef struct {
-    sem_t doctors;
-    sem_t machines;
-    sem_t rooms;
-    pthread_mutex_t log_mutex; // protects metrics/log updates
     int num_doctors;
     int num_machines;
     int num_rooms;
-    unsigned long long busy_doctors_ms;
-    unsigned long long busy_machines_ms;
-    unsigned long long busy_rooms_ms;
+    pthread_mutex_t lock;                // free lists, ready queue, timelines
+    struct ResourceWaiter **ready;       // sorted by (rank, arrival)
+    size_t ready_count;
+    size_t ready_cap;
+    uint64_t arrivals;                   // tie-break for equal ranks
+    ResourceAccount acct[RESOURCE_TYPE_COUNT];
+    int record_timeline;        // keep per-unit UnitIntervals (off by default)
+    uint64_t epoch_ms;          // CLOCK_MONOTONIC at init; timeline origin
+    LiveStats *live;            // optional observer of queue/acquire/release (NULL = none)
 } ResourcePool;
 
+// What an acquire handed out
+typedef struct {
+    ResourceMask mask;          // types held
+    int unit[RESOURCE_TYPE_COUNT];  // 0-based unit per held type, -1 otherwise
+    uint64_t waited_ms;         // time spent in the ready queue
+    uint64_t start_ms;          // grant time, ms since the pool's epoch
+} ResourceGrant;
+
+// Plain snapshot of one type's counters
+typedef struct {
+    int units;
+    uint64_t busy_ms;
+    uint64_t wait_ms;
+    uint64_t served;
+    int max_in_use;
+} ResourceTotals;
+
 int resources_init(ResourcePool *rp, int num_doctors, int num_machines, int num_rooms);
 void resources_destroy(ResourcePool *rp);
 
-sem_t *resource_for_service(ResourcePool *rp, ServiceType service);
+// Start keeping per-unit timelines. Call before any unit is acquired.
+void resources_enable_timeline(ResourcePool *rp);
+
+// Block until one unit of every type in mask is granted, all at once.
+// rank is the position in the scheduled order; lower ranks go first unless
+// their units are busy. Returns 0, or -1 if mask is empty or the ready
+// queue could not grow.
+int resources_acquire_set(ResourcePool *rp, ResourceMask mask, uint64_t rank, ResourceGrant *grant);
+// Single-type shorthand for resources_acquire_set(rp, RESOURCE_MASK(t), ...)
+int resources_acquire(ResourcePool *rp, ResourceType t, uint64_t rank, ResourceGrant *grant);
+// Give every held unit back, crediting busy_ms of service to each.
+void resources_release(ResourcePool *rp, const ResourceGrant *grant, int patient_id, uint64_t busy_ms);
+
+// Credit a slice served on a unit by a simulation that assigns units itself.
+void resources_record_slice(ResourcePool *rp, ResourceType t, int unit, int patient_id,
+                            uint64_t start_ms, uint64_t end_ms);
+// Fold type-level counters gathered elsewhere (e.g. the DES) into t.
+void resources_merge_totals(ResourcePool *rp, ResourceType t, const ResourceTotals *add);
+
+void resources_totals(const ResourcePool *rp, ResourceType t, ResourceTotals *out);
+int resources_units(const ResourcePool *rp, ResourceType t);
+uint64_t resources_unit_busy_ms(const ResourcePool *rp, ResourceType t, int unit);
+// Recorded intervals of one unit in completion order (empty unless enabled).
+const UnitTimeline *resources_unit_timeline(const ResourcePool *rp, ResourceType t, int unit);
 
 #endif // RESOURCES_H
@@ -0,0 +1,68 @@
+#ifndef SCHEDCACHE_H
+#define SCHEDCACHE_H
+
+#include "scheduler.h"
+
+// Per-algorithm schedule cache for a patient list that is edited one patient
+// at a time (the UI). Entries are computed on first use. After an edit:
+//  - FCFS, SJF and Priority are updated in place. Every dispatch decision
+//    taken before the edited patient was served and before its new arrival
+//    is unaffected, so that prefix of the order is kept and only the suffix
+//    is replayed through the dispatch engine, starting at the time the prefix
+//    ends. Averages and histograms are adjusted by the suffix's old and new
+//    contributions.
+//  - RR, SRTF and preemptive Priority are invalidated and recomputed on the
+//    next lookup.
+// Pointers returned by the lookups stay valid until the next edit,
+// invalidation or quantum change.
+
+typedef struct {
+    int valid;
+    uint64_t version;            // bumped whenever this algorithm's schedule may have changed
+    int *order;                  // patient indices in dispatch order
+    unsigned long long *start;   // FCFS/SJF/Priority: start time of each position
+    ScheduleMetrics metrics;
+    MetricsHistograms hist;      // FCFS/SJF/Priority: kept for incremental updates
+    uint64_t total_wait_ms;
+    uint64_t total_turnaround_ms;
+} ScheduleCacheEntry;
+
+typedef struct {
+    ScheduleCacheEntry entries[ALG_COUNT];
+    int *by_arrival;             // patient indices by (arrival_ms, index), when arrival_valid
+    int arrival_valid;
+    unsigned char *in_prefix;    // scratch for suffix replays
+    size_t count;                // patients the cached arrays describe
+    size_t cap;                  // allocated length of every per-patient array
+    unsigned quantum_ms;
+} ScheduleCache;
+
+void schedule_cache_init(ScheduleCache *c, unsigned quantum_ms);
+void schedule_cache_free(ScheduleCache *c);
+
+// The whole list was replaced (load, clear): drop every entry.
+void schedule_cache_invalidate(ScheduleCache *c);
+// Only the RR entry depends on the quantum.
+void schedule_cache_set_quantum(ScheduleCache *c, unsigned quantum_ms);
+
+// Report an edit once it has been applied to list:
+//  added:   the new patient is the last item
+//  changed: items[idx] was *before
+//  removed: *before was at idx and later items moved down by one
+void schedule_cache_added(ScheduleCache *c, const PatientList *list);
+void schedule_cache_changed(ScheduleCache *c, const PatientList *list, size_t idx, const Patient *before);
+void schedule_cache_removed(ScheduleCache *c, const PatientList *list, size_t idx, const Patient *before);
+
+// Lookups compute a missing entry first. They return NULL on allocation failure.
+const int *schedule_cache_order(ScheduleCache *c, const PatientList *list, Algorithm alg);
+const ScheduleMetrics *schedule_cache_metrics(ScheduleCache *c, const PatientList *list, Algorithm alg);
+// Start time per order position; NULL for RR and the preemptive algorithms,
+// whose patients may run in several slices.
+const unsigned long long *schedule_cache_starts(ScheduleCache *c, const PatientList *list, Algorithm alg);
+
+// Compute every missing entry, one thread per algorithm.
+void schedule_cache_refresh_all(ScheduleCache *c, const PatientList *list);
+
+uint64_t schedule_cache_version(const ScheduleCache *c, Algorithm alg);
+
+#endif // SCHEDCACHE_H
@@ -2,25 +2,102 @@
 #define SCHEDULER_H
 
 #include "patient.h"
+#include "histogram.h"
 
 typedef enum {
     ALG_FCFS = 0,
     ALG_SJF = 1,
     ALG_PRIORITY = 2,
-    ALG_RR = 3
+    ALG_RR = 3,
+    ALG_SRTF = 4,                 // preemptive SJF (shortest remaining time first)
+    ALG_PRIORITY_PREEMPTIVE = 5
 } Algorithm;
 
+#define ALG_COUNT 6
+
+// Priority classes for tail breakdowns: priorities 1..5, values outside that
+// range count towards the nearest end.
+#define METRICS_PRIORITY_CLASSES 5
+
+static inline int metrics_priority_class(int priority) {
+    return priority < 1 ? 0 : priority > METRICS_PRIORITY_CLASSES ? METRICS_PRIORITY_CLASSES - 1 : priority - 1;
+}
+
+// Service breakdown slot; unknown services count towards the last one.
+static inline unsigned metrics_service_class(unsigned service) {
+    return service < SERVICE_TYPE_COUNT ? service : SERVICE_TYPE_COUNT - 1;
+}
+
+// Tail of one latency distribution, in ms. Percentiles are bucket upper
+// bounds from a Histogram, so they overstate by at most 12.5%; max is exact.
+typedef struct {
+    uint64_t count;
+    uint64_t p50, p95, p99, max;
+} LatencySummary;
+
+// Raw histograms behind ScheduleMetrics; merge them with
+// metrics_histograms_merge and summarize with metrics_summarize.
+typedef struct {
+    Histogram wait;
+    Histogram turnaround;
+    Histogram wait_by_priority[METRICS_PRIORITY_CLASSES];
+    Histogram wait_by_service[SERVICE_TYPE_COUNT];
+} MetricsHistograms;
+
 typedef struct {
     double avg_wait_ms;
     double avg_turnaround_ms;
+    LatencySummary wait;
+    LatencySummary turnaround;
+    LatencySummary wait_by_priority[METRICS_PRIORITY_CLASSES];
+    LatencySummary wait_by_service[SERVICE_TYPE_COUNT];
 } ScheduleMetrics;
 
 // Returns an array of indices representing scheduling order.
+// FCFS/RR sort by arrival. SJF, Priority, SRTF and preemptive Priority return
+// the order in which the arrival-aware dispatch engine first serves each patient.
 int *schedule_order(const PatientList *list, Algorithm alg, unsigned quantum_ms);
 
 // Compute waiting and turnaround times per patient based on order.
 ScheduleMetrics compute_metrics(const PatientList *list, const int *order, Algorithm alg, unsigned quantum_ms);
 
+// Same as schedule_order/compute_metrics on a columnar view. The list versions
+// gather columns on every call; callers that schedule the same patients
+// repeatedly should build the columns once and use these.
+int *schedule_order_columns(const PatientColumns *cols, Algorithm alg, unsigned quantum_ms);
+ScheduleMetrics compute_metrics_columns(const PatientColumns *cols, const int *order, Algorithm alg, unsigned quantum_ms);
+
+// As compute_metrics_columns, also returning the histograms in *hist (may be
+// NULL) for callers that combine several runs.
+ScheduleMetrics compute_metrics_hist(const PatientColumns *cols, const int *order, Algorithm alg, unsigned quantum_ms,
+                                     MetricsHistograms *hist);
+
+LatencySummary latency_summary(const Histogram *h);
+// Count one patient's wait and turnaround in the overall and per-class histograms.
+void metrics_histograms_record(MetricsHistograms *h, int priority, unsigned service,
+                               uint64_t wait, uint64_t turnaround);
+void metrics_histograms_merge(MetricsHistograms *dst, const MetricsHistograms *src);
+// Fill the LatencySummary fields of m from hist (averages are left alone).
+void metrics_summarize(const MetricsHistograms *hist, ScheduleMetrics *m);
+
+// Evaluate every algorithm on the same list, one thread per algorithm.
+// schedule_order/compute_metrics keep no shared state, so this is safe.
+void compute_all_metrics(const PatientList *list, unsigned quantum_ms, ScheduleMetrics out[ALG_COUNT]);
+
+// Backend used for every (key, index) ordering.
+typedef enum {
+    SORT_RADIX = 0,   // LSD radix sort over the 32 key bits: linear time (default)
+    SORT_QSORT = 1    // qsort over packed 64-bit words
+} SortBackend;
+
+// Select the ordering backend. Set it once before scheduling starts.
+void set_sort_backend(SortBackend backend);
+SortBackend get_sort_backend(void);
+
+// Fill order[0..n) with 0..n-1 sorted by keys[] ascending, ties in index order.
+// Reentrant; returns -1 on allocation failure.
+int sort_indices_by_key(const unsigned *keys, size_t n, int *order);
+
 const char *alg_name(Algorithm alg);
 
 #endif // SCHEDULER_H
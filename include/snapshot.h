@@ -0,0 +1,76 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "patient.h"
+
+// Binary patient snapshot (.hrs): a header, then one 64-byte aligned section
+// per column, in the exact in-memory layout of PatientColumns plus the
+// pathway columns. Opening a snapshot maps the file and points the columns
+// into the mapping: nothing is parsed or copied, only the one-byte service
+// and pathway columns are range-checked. Little-endian only.
+//
+//   HrsHeader | id | priority | arrival_ms | burst_ms | service | name_off | names | path_len | path
+
+#define HRS_MAGIC 0x31535248u        // "HRS1" as little-endian bytes
+#define HRS_VERSION 1
+#define HRS_ALIGN 64
+
+#define HRS_HAS_PATHS 1u             // flags: path_len/path sections present
+
+typedef enum {
+    HRS_SEC_ID = 0,
+    HRS_SEC_PRIORITY,
+    HRS_SEC_ARRIVAL,
+    HRS_SEC_BURST,
+    HRS_SEC_SERVICE,
+    HRS_SEC_NAME_OFF,
+    HRS_SEC_NAMES,
+    HRS_SEC_PATH_LEN,
+    HRS_SEC_PATH,
+    HRS_SEC_COUNT
+} HrsSection;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;                  // patients
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t names_bytes;            // size of the string table
+    uint64_t offset[HRS_SEC_COUNT];  // byte offset of each section (0 = absent)
+} HrsHeader;
+
+_Static_assert(sizeof(PathStep) == 8, "PathStep is stored as-is in snapshots");
+
+// An open snapshot. cols points into the read-only mapping (never pass it to
+// patient_columns_free); path_len/path are NULL when the file has no pathways.
+typedef struct {
+    void *map;
+    size_t size;
+    PatientColumns cols;
+    const unsigned char *path_len;
+    const PathStep *path;            // [count * MAX_PATH_STEPS]
+} Snapshot;
+
+// Write list to path (via a temporary file and rename). Returns 0 or -1.
+int snapshot_write(const char *path, const PatientList *list);
+
+// Map path and validate its header, services and pathway steps. Returns 0,
+// or -1 with a reason in err (may be NULL) if the file is unreadable or not
+// a valid snapshot.
+int snapshot_open(const char *path, Snapshot *snap, char *err, size_t errsz);
+void snapshot_close(Snapshot *snap);
+
+// Materialize rows for code that works on a PatientList. Returns 0 or -1.
+int snapshot_to_list(const Snapshot *snap, PatientList *out);
+
+// Row i alone, rebuilt from the columns.
+void snapshot_patient(const Snapshot *snap, size_t i, Patient *out);
+// The snapshot's patients one row at a time, without materializing them all.
+// Valid while snap stays open.
+PatientSource snapshot_source(const Snapshot *snap);
+
+// 1 if path names a snapshot (by its .hrs extension).
+int snapshot_is_path(const char *path);
+
+#endif // SNAPSHOT_H
@@ -3,10 +3,58 @@
 
 #include "patient.h"
 
-// Load patients from CSV file: id,name,service,priority,required_ms,arrival_ms
+#define CSV_SKIPPED_LINES 8
+
+// Where and why a load failed, or which malformed lines a successful load
+// skipped. line is 1-based (0: not tied to a line); for skips, line and msg
+// describe the first skipped line.
+typedef struct {
+    size_t line;
+    char msg[128];
+    size_t skipped;                           // malformed lines skipped
+    size_t skipped_line[CSV_SKIPPED_LINES];   // the first of them, in file order
+} CsvError;
+
+// Load patients from CSV file: id,name,service,priority,required_ms,arrival_ms[,pathway]
+// pathway is optional, e.g. "Consultation:300>Lab Test:500>Treatment+Doctor:200"; when
+// present it replaces service and required_ms. "+Doctor" etc. holds that resource too.
 // Returns 0 on success; populates PatientList (allocates memory). On failure returns -1.
+// Blank lines and lines starting with '#' are ignored. Other malformed lines
+// are skipped and counted; an unknown service name falls back to Consultation.
 int load_patients_csv(const char *path, PatientList *out_list);
 
+// "skipped 3 malformed lines (12, 40, 41); line 12: bad priority 'x7'",
+// or "" when nothing was skipped.
+void csv_format_skips(const CsvError *err, char *buf, size_t size);
+
+// As load_patients_csv, describing an error or the skipped lines in *err (may be NULL).
+// The file is mmap'd and scanned in place with one allocation for the result;
+// large files are split at line boundaries and parsed on all online CPUs.
+int load_patients_csv_ex(const char *path, PatientList *out_list, CsvError *err);
+
+// As load_patients_csv_ex on at most `threads` threads (<= 0: online CPUs).
+// Files are never cut into chunks smaller than 1 MiB.
+int load_patients_csv_mt(const char *path, PatientList *out_list, CsvError *err, int threads);
+
+// Record-at-a-time CSV reader for inputs that are too large to hold or that
+// are still being written (pipes, stdin). Same format and skipping as above.
+typedef struct {
+    FILE *fp;
+    char *line;               // getline buffer, reused for every record
+    size_t cap;
+    size_t line_no;
+    int owns_fp;
+    CsvError skips;           // malformed lines passed over so far
+} CsvReader;
+
+// Open path for reading; "-" reads stdin. Returns 0, or -1 with errno set.
+int csv_reader_open(CsvReader *r, const char *path);
+// Parse the next record into *out, skipping malformed lines (noted in
+// r->skips). Returns 1 on a record, 0 at end of input and -1 on a read error
+// (described in *err, may be NULL).
+int csv_reader_next(CsvReader *r, Patient *out, CsvError *err);
+void csv_reader_close(CsvReader *r);
+
 // Save patients to CSV file. Returns 0 on success.
 int save_patients_csv(const char *path, const PatientList *list);
 
@@ -0,0 +1,31 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "scheduler.h"
+#include "storage.h"
+
+// Streaming replay: patients are read one record at a time from an
+// arrival-sorted CSV (file or stdin) and fed straight into the dispatch
+// engine's ready queue, so scheduling starts with the first record and
+// memory is bounded by the patients in flight (arrived, not yet finished)
+// rather than by the length of the input.
+
+typedef struct {
+    Algorithm alg;           // any algorithm dispatch_supports()
+    FILE *out;               // per-patient rows as they finish (NULL: summary only)
+} StreamConfig;
+
+typedef struct {
+    size_t patients;
+    double avg_wait_ms;
+    double avg_turnaround_ms;
+    unsigned long long makespan_ms;
+    size_t peak_in_flight;   // most patients arrived but not yet finished
+} StreamResult;
+
+// Replay path ("-" for stdin). Returns 0 with any skipped malformed lines
+// in *err, or -1 with *err describing a read error or the first
+// out-of-order record (err may be NULL).
+int stream_run(const char *path, const StreamConfig *cfg, StreamResult *res, CsvError *err);
+
+#endif // STREAM_H
@@ -0,0 +1,65 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "patient.h"
+#include "scheduler.h"
+
+// Headless capacity-planning sweep: every selected algorithm is replayed in
+// the DES engine (patients released at their arrival time) for each point of
+// a quantum x doctors x machines x rooms grid. Cells run on a pool of threads.
+// The DES only gives a unit up at the end of a stage or quantum, so SRTF and
+// preemptive Priority cannot be replayed and are not accepted.
+
+#define SWEEP_MAX_VALUES 32
+
+typedef enum {
+    SWEEP_CSV = 0,
+    SWEEP_JSON = 1
+} SweepFormat;
+
+typedef struct {
+    Algorithm algs[ALG_COUNT];
+    size_t num_algs;
+    unsigned quanta[SWEEP_MAX_VALUES];   // applied to RR only
+    size_t num_quanta;
+    int doctors[SWEEP_MAX_VALUES];
+    size_t num_doctors;
+    int machines[SWEEP_MAX_VALUES];
+    size_t num_machines;
+    int rooms[SWEEP_MAX_VALUES];
+    size_t num_rooms;
+    int threads;                         // <= 0: one per online CPU
+    SweepFormat format;
+} SweepConfig;
+
+typedef struct {
+    Algorithm alg;
+    unsigned quantum_ms;                 // 0 for algorithms without a quantum
+    int doctors, machines, rooms;
+    double avg_wait_ms;
+    double avg_turnaround_ms;
+    double p50_wait_ms;                  // percentiles from a Histogram (see histogram.h)
+    double p95_wait_ms;
+    double p99_wait_ms;
+    double max_wait_ms;
+    unsigned long long makespan_ms;
+    double util_doctors, util_machines, util_rooms;
+} SweepRow;
+
+// Every algorithm sweep_supports(), quantum 3 ms, the CLI's default resource counts.
+void sweep_default_config(SweepConfig *cfg);
+
+// 1 if alg can be replayed in the DES (FCFS, SJF, Priority, RR), else 0.
+int sweep_supports(Algorithm alg);
+
+// Parse a comma-separated list of positive integers into vals (at most
+// SWEEP_MAX_VALUES). Returns the count, or -1 on a malformed list.
+int sweep_parse_list(const char *s, int *vals);
+
+// Run the grid and write one row per cell to out. Returns 0 on success.
+int run_sweep(const SweepConfig *cfg, const PatientList *list, FILE *out);
+// As run_sweep on patients read from src, already gathered into cols (e.g. a
+// mapped snapshot's source and columns, so no rows are materialized).
+int run_sweep_columns(const SweepConfig *cfg, const PatientSource *src, const PatientColumns *cols, FILE *out);
+
+#endif // SWEEP_H
@@ -4,13 +4,42 @@
 #include <pthread.h>
 #include "resources.h"
 #include "ipc.h"
+#include "logring.h"
 
 typedef struct {
     Patient patient;
+    size_t rank;                // position in the scheduled order
     ResourcePool *resources;
-    int fifo_fd;
+    LogRing *log;
 } WorkerArgs;
 
 void *patient_thread(void *arg);
 
+// Serve one patient on the calling thread: log START, then for each stage of
+// its pathway hold one unit of that stage's resource for the stage duration,
+// account busy time, and finally log FINISH.
+// rank is the patient's position in the schedule; it orders the unit's ready queue.
+void serve_patient(const Patient *p, size_t rank, ResourcePool *rp, LogRing *log);
+
+// Run every patient of `order` on a fixed pool of `workers` threads. Patients
+// are queued by the resource type of their first stage; a worker claims the
+// earliest-scheduled patient among the types with fewer claimed patients in
+// their first stage than units, so every type keeps a claimable patient.
+// workers <= 0 selects default_worker_count(), times the longest pathway.
+// Blocked workers are granted units in scheduled order. Returns 0 on
+// success, -1 if the pool could not be set up or no thread could start.
+int run_worker_pool(const PatientList *list, const int *order, ResourcePool *rp,
+                    LogRing *log, int workers);
+
+// Total resource capacity (doctors + machines + rooms): enough workers to keep
+// every unit busy, since workers spend their time blocked, not on the CPU.
+int default_worker_count(const ResourcePool *rp);
+
+// Queue one START/FINISH record on the log ring (no-op when log is NULL), tagged
+// with the stage it belongs to: START the first, FINISH the last one reached.
+// Shared by the threaded workers and the DES engine so both emit the same stream.
+void log_patient_event(LogRing *log, LogEvent event, const Patient *p, ServiceType stage);
+void log_patient_event_at(LogRing *log, LogEvent event, const Patient *p, ServiceType stage,
+                          uint64_t ts_ns);
+
 #endif // THREAD_WORKER_H
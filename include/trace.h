@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Opt-in hot-path tracing, exported as Chrome trace-event JSON (chrome://tracing,
+// ui.perfetto.dev).
+// Each thread appends complete ("X") events to its own chunked buffer, so
+// recording takes no lock. Timestamps are CLOCK_MONOTONIC, which is shared
+// by every process, so the logger's events line up with the scheduler's.
+// When tracing is off, each trace point costs one well-predicted branch on
+// trace_enabled.
+
+#define TRACE_CHUNK_EVENTS 4096
+#define TRACE_MAX_CHUNKS 256       // per thread; later events are dropped and counted
+
+// Set once by trace_start(), before any traced thread is created
+extern int trace_enabled;
+
+// Turn tracing on for this process; process_name labels it in the viewer.
+void trace_start(const char *process_name);
+
+// Label the calling thread (e.g. "worker", "log flusher").
+void trace_thread_name(const char *name);
+
+uint64_t trace_now_ns(void);
+
+// Append a complete event from start_ns to now. name and arg_name must be
+// string literals or otherwise outlive the trace; arg_name may be NULL.
+void trace_record(const char *name, uint64_t start_ns, const char *arg_name, int64_t arg);
+
+static inline uint64_t trace_begin(void) {
+    return __builtin_expect(trace_enabled, 0) ? trace_now_ns() : 0;
+}
+
+static inline void trace_end(const char *name, uint64_t start_ns, const char *arg_name, int64_t arg) {
+    if (__builtin_expect(trace_enabled, 0)) trace_record(name, start_ns, arg_name, arg);
+}
+
+// Write this process's events as one JSON object per line, for another
+// process to merge with trace_write_json(). Returns 0 or -1.
+int trace_write_fragment(const char *path);
+
+// Write {"traceEvents":[...]} with this process's events, followed by the
+// lines of fragment_path when it is non-NULL and exists. Call after every
+// traced thread has been joined. Returns 0 or -1.
+int trace_write_json(const char *path, const char *fragment_path);
+
+// Free every buffer and turn tracing off.
+void trace_reset(void);
+
+#endif // TRACE_H
@@ -0,0 +1,56 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "patient.h"
+
+// Seeded synthetic workloads. Patients are generated in fixed blocks of
+// WORKLOAD_BLOCK, each with its own xoshiro256** streams derived from the
+// seed, so the output depends only on the seed and the config and never on
+// the thread count. Poisson arrivals are cumulative over the whole list, so
+// ids come out in arrival order.
+
+#define WORKLOAD_BLOCK 65536
+#define WORKLOAD_PRIORITY_LEVELS 5   // priorities 1..5
+
+typedef enum {
+    ARRIVAL_UNIFORM = 0,     // independent draws in [0, window_ms)
+    ARRIVAL_POISSON = 1      // exponential gaps at rate_per_s
+} ArrivalDist;
+
+typedef enum {
+    SERVICE_TIME_UNIFORM = 0,      // [min_ms, max_ms]
+    SERVICE_TIME_EXPONENTIAL = 1,  // mean_ms, clamped to [clamp_min_ms, clamp_max_ms]
+    SERVICE_TIME_LOGNORMAL = 2     // mean_ms and log-space sigma, clamped likewise
+} ServiceTimeDist;
+
+typedef struct {
+    uint64_t seed;
+    ArrivalDist arrival;
+    unsigned window_ms;                          // ARRIVAL_UNIFORM
+    double rate_per_s;                           // ARRIVAL_POISSON
+    ServiceTimeDist service_time;
+    double mean_ms;
+    double sigma;
+    unsigned min_ms, max_ms;                     // SERVICE_TIME_UNIFORM
+    unsigned clamp_min_ms, clamp_max_ms;         // exponential and lognormal (--clamp)
+    double service_weights[SERVICE_TYPE_COUNT];  // relative, need not sum to 1
+    double priority_weights[WORKLOAD_PRIORITY_LEVELS];
+    int threads;                                 // <= 0: online CPUs
+} WorkloadConfig;
+
+// The classic random mix: arrivals uniform in [0, 500) ms, service times
+// uniform in [100, 1000) ms, services and priorities equally likely.
+void workload_default_config(WorkloadConfig *cfg, uint64_t seed);
+
+// Apply one CLI option (e.g. "--arrivals", "poisson:20"). Returns 1 if opt
+// is a workload option, 0 if not, and -1 (after printing why) on a bad value.
+int workload_parse_option(WorkloadConfig *cfg, const char *opt, const char *val);
+
+// Generate n patients into out. Returns 0, or -1 on allocation failure or
+// when arrivals would overflow 32-bit milliseconds (about 49 days).
+int generate_patients(const WorkloadConfig *cfg, size_t n, PatientList *out);
+
+// A seed that differs between runs, for callers that were not given one.
+uint64_t workload_time_seed(void);
+
+#endif // WORKLOAD_H
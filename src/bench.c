@@ -0,0 +1,648 @@
+// Benchmark harness: times the hot paths and prints one CSV row per case.
+// Usage: bin/bench [--max-n N] [--reps R] [--suites a,b,...]
+#include "common.h"
+#include "patient.h"
+#include "scheduler.h"
+#include "resources.h"
+#include "storage.h"
+#include "snapshot.h"
+#include "ipc.h"
+#include "workload.h"
+#include "schedcache.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// One row: suite,case,variant,n,best_ms,items_per_sec,mb_per_sec.
+// mb_per_sec is left empty for cases that do not move bytes.
+static void report_bytes(const char *suite, const char *name, const char *variant, size_t n, double ms,
+                         size_t bytes) {
+    double rate = ms > 0.0 ? n / (ms / 1000.0) : 0.0;
+    printf("%s,%s,%s,%zu,%.3f,%.0f,", suite, name, variant, n, ms, rate);
+    if (bytes && ms > 0.0) printf("%.1f", bytes / (1024.0 * 1024.0) / (ms / 1000.0));
+    putchar('\n');
+    fflush(stdout);
+}
+
+static void report(const char *suite, const char *name, const char *variant, size_t n, double ms) {
+    report_bytes(suite, name, variant, n, ms, 0);
+}
+
+// The default random mix from a fixed seed, so every run times the same input
+static PatientList bench_patients(size_t n) {
+    WorkloadConfig cfg;
+    workload_default_config(&cfg, 42);
+    PatientList list;
+    if (generate_patients(&cfg, n, &list) != 0) {
+        fprintf(stderr, "bench: cannot generate %zu patients\n", n);
+        exit(1);
+    }
+    return list;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Ordering: radix vs qsort over the same packed keys
+// ─────────────────────────────────────────────────────────────────────────────
+static void bench_ordering(size_t n, int reps) {
+    PatientList list = bench_patients(n);
+    int *order = (int *)malloc(sizeof(int) * n);
+    unsigned *keys = (unsigned *)malloc(sizeof(unsigned) * n);
+    const SortBackend backends[2] = { SORT_QSORT, SORT_RADIX };
+    const char *names[2] = { "qsort", "radix" };
+
+    for (int b = 0; b < 2; ++b) {
+        set_sort_backend(backends[b]);
+
+        double best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            double t0 = now_ms();
+            int *o = schedule_order(&list, ALG_FCFS, 0);
+            double t = now_ms() - t0;
+            free(o);
+            if (t < best) best = t;
+        }
+        report("ordering", "arrival", names[b], n, best);
+
+        for (size_t i = 0; i < n; ++i) keys[i] = list.items[i].required_time_ms;
+        best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            double t0 = now_ms();
+            sort_indices_by_key(keys, n, order);
+            double t = now_ms() - t0;
+            if (t < best) best = t;
+        }
+        report("ordering", "burst", names[b], n, best);
+    }
+    set_sort_backend(SORT_RADIX);
+
+    free(keys);
+    free(order);
+    free_patients(&list);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Scheduling: schedule_order and compute_metrics for every algorithm
+// ─────────────────────────────────────────────────────────────────────────────
+static const char *alg_keys[ALG_COUNT] = { "fcfs", "sjf", "priority", "rr", "srtf", "ppriority" };
+
+static void bench_scheduling(size_t n, int reps) {
+    PatientList list = bench_patients(n);
+    volatile double sink = 0.0;
+    for (int a = 0; a < ALG_COUNT; ++a) {
+        double best_order = 1e300, best_metrics = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            double t0 = now_ms();
+            int *order = schedule_order(&list, (Algorithm)a, 3);
+            double t1 = now_ms();
+            if (!order) break;
+            sink += compute_metrics(&list, order, (Algorithm)a, 3).avg_wait_ms;
+            double t2 = now_ms();
+            free(order);
+            if (t1 - t0 < best_order) best_order = t1 - t0;
+            if (t2 - t1 < best_metrics) best_metrics = t2 - t1;
+        }
+        report("scheduling", "schedule_order", alg_keys[a], n, best_order);
+        report("scheduling", "compute_metrics", alg_keys[a], n, best_metrics);
+    }
+    (void)sink;
+    free_patients(&list);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Layout: the non-preemptive metrics walk over Patient rows vs PatientColumns
+// ─────────────────────────────────────────────────────────────────────────────
+
+// The walk as it reads the row layout: every step pulls a whole Patient
+static double walk_rows(const PatientList *list, const int *order) {
+    unsigned long long time = 0;
+    double total_wait = 0.0;
+    for (size_t k = 0; k < list->count; ++k) {
+        Patient p = list->items[order[k]];
+        if (p.arrival_ms > time) time = p.arrival_ms;
+        total_wait += (double)(time - p.arrival_ms);
+        time += p.required_time_ms;
+    }
+    return total_wait;
+}
+
+static void bench_columns(size_t n, int reps) {
+    PatientList list = bench_patients(n);
+    PatientColumns cols;
+    if (patient_columns_build(&list, &cols, 0) != 0) { free_patients(&list); return; }
+    const Algorithm algs[2] = { ALG_FCFS, ALG_SJF };
+    const char *names[2] = { "fcfs_walk", "sjf_walk" };
+    volatile double sink = 0.0;
+
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        PatientColumns tmp;
+        double t0 = now_ms();
+        int rc = patient_columns_build(&list, &tmp, 0);
+        double t = now_ms() - t0;
+        if (rc == 0) patient_columns_free(&tmp);
+        if (t < best) best = t;
+    }
+    report("layout", "gather", "columns", n, best);
+
+    for (int a = 0; a < 2; ++a) {
+        int *order = schedule_order_columns(&cols, algs[a], 0);
+        if (!order) continue;
+
+        best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            double t0 = now_ms();
+            sink += walk_rows(&list, order);
+            double t = now_ms() - t0;
+            if (t < best) best = t;
+        }
+        report("layout", names[a], "rows", n, best);
+
+        best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            double t0 = now_ms();
+            sink += compute_metrics_columns(&cols, order, algs[a], 0).avg_wait_ms;
+            double t = now_ms() - t0;
+            if (t < best) best = t;
+        }
+        report("layout", names[a], "columns", n, best);
+        free(order);
+    }
+    (void)sink;
+
+    patient_columns_free(&cols);
+    free_patients(&list);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Gang acquisition stress: many threads contending for scarce resources.
+// Mix per thread: 50% doctor only, 20% machine only, 30% room AND doctor.
+// all_or_nothing takes room+doctor in one grant; ordered_nested takes the
+// doctor, then waits for a room while holding it. Every grant is checked
+// against capacity; any overrun aborts the run.
+// ─────────────────────────────────────────────────────────────────────────────
+#define GANG_THREADS 64
+#define GANG_UNITS_DOCTOR 2
+#define GANG_UNITS_MACHINE 1
+#define GANG_UNITS_ROOM 3
+
+typedef struct {
+    ResourcePool *rp;
+    int nested;
+    int iters;
+    unsigned seed;
+    _Atomic uint64_t *ticket;
+    _Atomic int *held;          // [RESOURCE_TYPE_COUNT] units held right now
+} GangArgs;
+
+static void gang_hold(_Atomic int *held, ResourceMask mask, int delta) {
+    const int caps[RESOURCE_TYPE_COUNT] = { GANG_UNITS_DOCTOR, GANG_UNITS_MACHINE, GANG_UNITS_ROOM };
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) {
+        if (!(mask & RESOURCE_MASK(t))) continue;
+        if (atomic_fetch_add(&held[t], delta) + delta > caps[t]) {
+            fprintf(stderr, "bench: resource %d over capacity\n", t);
+            abort();
+        }
+    }
+}
+
+static void *gang_worker(void *arg) {
+    GangArgs *ga = (GangArgs *)arg;
+    unsigned x = ga->seed;
+    for (int i = 0; i < ga->iters; ++i) {
+        x = x * 1103515245u + 12345u;
+        unsigned pick = (x >> 16) % 10;
+        ResourceMask mask = pick < 5 ? RESOURCE_MASK(RESOURCE_DOCTOR)
+                          : pick < 7 ? RESOURCE_MASK(RESOURCE_MACHINE)
+                          : RESOURCE_MASK(RESOURCE_ROOM) | RESOURCE_MASK(RESOURCE_DOCTOR);
+        uint64_t rank = atomic_fetch_add(ga->ticket, 1);
+        ResourceGrant g, g2;
+        int two = ga->nested && mask != RESOURCE_MASK(RESOURCE_DOCTOR) && (mask & RESOURCE_MASK(RESOURCE_DOCTOR));
+        if (two) {
+            if (resources_acquire(ga->rp, RESOURCE_DOCTOR, rank, &g) != 0) abort();
+            if (resources_acquire(ga->rp, RESOURCE_ROOM, rank, &g2) != 0) abort();
+        } else if (resources_acquire_set(ga->rp, mask, rank, &g) != 0) {
+            abort();
+        }
+        gang_hold(ga->held, mask, 1);
+        sched_yield();
+        gang_hold(ga->held, mask, -1);
+        if (two) resources_release(ga->rp, &g2, 0, 0);
+        resources_release(ga->rp, &g, 0, 0);
+    }
+    return NULL;
+}
+
+static void bench_gang(int iters, int reps) {
+    const char *variants[2] = { "all_or_nothing", "ordered_nested" };
+    size_t ops = (size_t)GANG_THREADS * (size_t)iters;
+    for (int v = 0; v < 2; ++v) {
+        double best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            ResourcePool rp;
+            if (resources_init(&rp, GANG_UNITS_DOCTOR, GANG_UNITS_MACHINE, GANG_UNITS_ROOM) != 0) return;
+            _Atomic uint64_t ticket = 0;
+            _Atomic int held[RESOURCE_TYPE_COUNT] = {0};
+            GangArgs args[GANG_THREADS];
+            pthread_t th[GANG_THREADS];
+            int started = 0;
+            double t0 = now_ms();
+            for (int i = 0; i < GANG_THREADS; ++i) {
+                args[i] = (GangArgs){ &rp, v, iters, 0x9e3779b9u * (unsigned)(i + 1), &ticket, held };
+                if (pthread_create(&th[i], NULL, gang_worker, &args[i]) != 0) break;
+                started++;
+            }
+            for (int i = 0; i < started; ++i) pthread_join(th[i], NULL);
+            double t = now_ms() - t0;
+            resources_destroy(&rp);
+            if (t < best) best = t;
+        }
+        report("gang", "mixed_64_threads", variants[v], ops, best);
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Loader: CSV on one thread and on all CPUs, and .hrs snapshots, from a warm
+// page cache. Throughput is over the CSV's size for the CSV variants and the
+// snapshot's size for hrs_to_list.
+// ─────────────────────────────────────────────────────────────────────────────
+static size_t file_size(const char *path) {
+    struct stat sb;
+    return stat(path, &sb) == 0 ? (size_t)sb.st_size : 0;
+}
+
+static void bench_loader(size_t n, int reps) {
+    char csv[64], hrs[64];
+    snprintf(csv, sizeof(csv), "/tmp/hospital_bench_%d.csv", (int)getpid());
+    snprintf(hrs, sizeof(hrs), "/tmp/hospital_bench_%d.hrs", (int)getpid());
+    PatientList list = bench_patients(n);
+    int ok = save_patients_csv(csv, &list) == 0 && snapshot_write(hrs, &list) == 0;
+    free_patients(&list);
+    if (!ok) {
+        fprintf(stderr, "bench: cannot write loader inputs in /tmp\n");
+        unlink(csv); unlink(hrs);
+        return;
+    }
+
+    const int threads[2] = { 1, 0 };
+    const char *variants[2] = { "csv_1_thread", "csv_all_cpus" };
+    for (int v = 0; v < 2; ++v) {
+        double best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            PatientList loaded;
+            double t0 = now_ms();
+            int rc = load_patients_csv_mt(csv, &loaded, NULL, threads[v]);
+            double t = now_ms() - t0;
+            if (rc != 0) break;
+            free_patients(&loaded);
+            if (t < best) best = t;
+        }
+        report_bytes("loader", "load", variants[v], n, best, file_size(csv));
+    }
+
+    double best_open = 1e300, best_list = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        Snapshot snap;
+        PatientList loaded;
+        double t0 = now_ms();
+        if (snapshot_open(hrs, &snap, NULL, 0) != 0) break;
+        double t1 = now_ms();
+        int rc = snapshot_to_list(&snap, &loaded);
+        double t2 = now_ms();
+        snapshot_close(&snap);
+        if (rc != 0) break;
+        free_patients(&loaded);
+        if (t1 - t0 < best_open) best_open = t1 - t0;
+        if (t2 - t0 < best_list) best_list = t2 - t0;
+    }
+    report("loader", "load", "hrs_open", n, best_open);   // maps, reads no column data
+    report_bytes("loader", "load", "hrs_to_list", n, best_list, file_size(hrs));
+
+    unlink(csv);
+    unlink(hrs);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Log transports: LogRecords from one producer to a consumer thread over a
+// FIFO (LOG_RING_BATCH records per write, as the flusher sends them), a POSIX
+// message queue (one record per message) and the shared-memory ring. Private
+// FIFO/queue names, so a concurrent run is not disturbed.
+// ─────────────────────────────────────────────────────────────────────────────
+#define BENCH_LOG_BATCH 256
+
+typedef struct {
+    int kind;                  // 0 fifo, 1 mq, 2 shm ring
+    const char *fifo_path;
+    mqd_t mq;
+    ShmLogRing *ring;
+    size_t records;
+    size_t received;
+} LogPipeArgs;
+
+static void *log_consumer(void *arg) {
+    LogPipeArgs *a = (LogPipeArgs *)arg;
+    if (a->kind == 0) {
+        int fd = open(a->fifo_path, O_RDONLY);
+        if (fd == -1) return NULL;
+        static char buf[1 << 16];
+        ssize_t got;
+        size_t bytes = 0;
+        while ((got = read(fd, buf, sizeof(buf))) > 0) bytes += (size_t)got;
+        close(fd);
+        a->received = bytes / sizeof(LogRecord);
+    } else if (a->kind == 1) {
+        LogRecord rec;
+        while (a->received < a->records && mq_receive(a->mq, (char *)&rec, sizeof(rec), NULL) == (ssize_t)sizeof(rec))
+            a->received++;
+    } else {
+        uint64_t head = 0;
+        for (;;) {
+            size_t avail = shm_log_wait(a->ring, 0, 10);
+            int closed = atomic_load(&a->ring->closed) != 0;
+            if (closed) avail = (size_t)(atomic_load(&a->ring->tail) - head);
+            head += avail;
+            a->received += avail;
+            atomic_store_explicit(&a->ring->head, head, memory_order_release);
+            if (closed) break;
+        }
+    }
+    return NULL;
+}
+
+static int log_produce(LogPipeArgs *a, const LogRecord *batch) {
+    if (a->kind == 1) {
+        for (size_t i = 0; i < a->records; ++i)
+            if (mq_send(a->mq, (const char *)&batch[i % BENCH_LOG_BATCH], sizeof(LogRecord), 0) != 0) return -1;
+        return 0;
+    }
+    if (a->kind == 2) {
+        for (size_t i = 0; i < a->records; i += BENCH_LOG_BATCH) {
+            size_t k = a->records - i < BENCH_LOG_BATCH ? a->records - i : BENCH_LOG_BATCH;
+            shm_log_write(a->ring, batch, k);
+        }
+        shm_log_close(a->ring);
+        return 0;
+    }
+    int fd = open(a->fifo_path, O_WRONLY);
+    if (fd == -1) return -1;
+    int rc = 0;
+    for (size_t i = 0; i < a->records && rc == 0; i += BENCH_LOG_BATCH) {
+        size_t k = a->records - i < BENCH_LOG_BATCH ? a->records - i : BENCH_LOG_BATCH;
+        const char *p = (const char *)batch;
+        size_t len = k * sizeof(LogRecord);
+        while (len > 0) {
+            ssize_t w = write(fd, p, len);
+            if (w <= 0) { rc = -1; break; }
+            p += w;
+            len -= (size_t)w;
+        }
+    }
+    close(fd);
+    return rc;
+}
+
+static void bench_log_transport(size_t records, int reps) {
+    const char *variants[3] = { "fifo", "mq", "shm_ring" };
+    char fifo_path[64], mq_name[64];
+    snprintf(fifo_path, sizeof(fifo_path), "/tmp/hospital_bench_fifo_%d", (int)getpid());
+    snprintf(mq_name, sizeof(mq_name), "/hospital_bench_mq_%d", (int)getpid());
+    LogRecord batch[BENCH_LOG_BATCH];
+    for (int i = 0; i < BENCH_LOG_BATCH; ++i)
+        batch[i] = (LogRecord){ .ts_ns = (uint64_t)i, .patient_id = i, .event = (uint8_t)(i & 1) };
+
+    for (int v = 0; v < 3; ++v) {
+        double best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            LogPipeArgs a = { .kind = v, .fifo_path = fifo_path, .mq = (mqd_t)-1, .records = records };
+            if (v == 0 && mkfifo(fifo_path, 0600) != 0) break;
+            if (v == 1) {
+                struct mq_attr attr = { .mq_maxmsg = 10, .mq_msgsize = sizeof(LogRecord) };
+                a.mq = mq_open(mq_name, O_CREAT | O_RDWR, 0600, &attr);
+                if (a.mq == (mqd_t)-1) break;
+            }
+            if (v == 2) {
+                a.ring = (ShmLogRing *)mmap(NULL, sizeof(ShmLogRing), PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+                if (a.ring == MAP_FAILED) break;
+                a.ring->capacity = SHM_LOG_CAPACITY;
+            }
+            pthread_t th;
+            double t0 = now_ms();
+            int rc = pthread_create(&th, NULL, log_consumer, &a);
+            if (rc == 0) {
+                rc = log_produce(&a, batch);
+                pthread_join(th, NULL);
+            }
+            double t = now_ms() - t0;
+            if (v == 0) unlink(fifo_path);
+            if (v == 1) { mq_close(a.mq); mq_unlink(mq_name); }
+            if (v == 2) munmap(a.ring, sizeof(ShmLogRing));
+            if (rc != 0 || a.received != records) {
+                fprintf(stderr, "bench: %s transport delivered %zu of %zu records\n", variants[v], a.received, records);
+                break;
+            }
+            if (t < best) best = t;
+        }
+        if (best < 1e300) report_bytes("log_transport", "records", variants[v], records, best, records * sizeof(LogRecord));
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// ResourcePool contention: T threads acquire and release one doctor in a tight
+// loop against a pool of RESOURCE_BENCH_DOCTORS, so the cost per operation is
+// the pool lock plus, once T exceeds the units, the ready queue handoff.
+// ─────────────────────────────────────────────────────────────────────────────
+#define RESOURCE_BENCH_DOCTORS 3
+#define RESOURCE_BENCH_MAX_THREADS 32
+
+typedef struct {
+    ResourcePool *rp;
+    int iters;
+    _Atomic uint64_t *ticket;
+} ContentionArgs;
+
+static void *contention_worker(void *arg) {
+    ContentionArgs *ca = (ContentionArgs *)arg;
+    for (int i = 0; i < ca->iters; ++i) {
+        ResourceGrant g;
+        if (resources_acquire(ca->rp, RESOURCE_DOCTOR, atomic_fetch_add(ca->ticket, 1), &g) != 0) abort();
+        resources_release(ca->rp, &g, 0, 0);
+    }
+    return NULL;
+}
+
+static void bench_contention(int iters, int reps) {
+    for (int nthreads = 1; nthreads <= RESOURCE_BENCH_MAX_THREADS; nthreads *= 2) {
+        double best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            ResourcePool rp;
+            if (resources_init(&rp, RESOURCE_BENCH_DOCTORS, 1, 1) != 0) return;
+            _Atomic uint64_t ticket = 0;
+            ContentionArgs args = { &rp, iters, &ticket };
+            pthread_t th[RESOURCE_BENCH_MAX_THREADS];
+            int started = 0;
+            double t0 = now_ms();
+            for (int i = 0; i < nthreads; ++i) {
+                if (pthread_create(&th[i], NULL, contention_worker, &args) != 0) break;
+                started++;
+            }
+            for (int i = 0; i < started; ++i) pthread_join(th[i], NULL);
+            double t = now_ms() - t0;
+            resources_destroy(&rp);
+            if (t < best) best = t;
+        }
+        char variant[32];
+        snprintf(variant, sizeof(variant), "%d_threads", nthreads);
+        report("contention", "acquire_release", variant, (size_t)nthreads * (size_t)iters, best);
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Generator: Poisson arrivals with lognormal service times, on one thread and
+// on all CPUs (the output is identical either way)
+// ─────────────────────────────────────────────────────────────────────────────
+static void bench_generator(size_t n, int reps) {
+    const int threads[2] = { 1, 0 };
+    const char *variants[2] = { "1_thread", "all_cpus" };
+    for (int v = 0; v < 2; ++v) {
+        WorkloadConfig cfg;
+        workload_default_config(&cfg, 42);
+        cfg.arrival = ARRIVAL_POISSON;
+        cfg.rate_per_s = 1000.0;
+        cfg.service_time = SERVICE_TIME_LOGNORMAL;
+        cfg.threads = threads[v];
+        double best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            PatientList list;
+            double t0 = now_ms();
+            int rc = generate_patients(&cfg, n, &list);
+            double t = now_ms() - t0;
+            if (rc != 0) break;
+            free_patients(&list);
+            if (t < best) best = t;
+        }
+        report("generator", "poisson_lognormal", variants[v], n, best);
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Schedule cache: one UI-style edit plus a metrics lookup, patched in place
+// (suffix replay) vs scheduled from scratch. Poisson arrivals at ~88% load keep
+// the schedule spread out, as in an imported admissions log.
+// ─────────────────────────────────────────────────────────────────────────────
+static void bench_schedule_cache(size_t n, int reps) {
+    WorkloadConfig cfg;
+    workload_default_config(&cfg, 42);
+    cfg.arrival = ARRIVAL_POISSON;
+    cfg.rate_per_s = 1.6;
+    PatientList list;
+    if (generate_patients(&cfg, n, &list) != 0) return;
+    Patient *items = (Patient *)realloc(list.items, sizeof(Patient) * (n + 1));
+    if (!items) { free_patients(&list); return; }
+    list.items = items;
+
+    const Algorithm algs[3] = { ALG_FCFS, ALG_SJF, ALG_PRIORITY };
+    volatile double sink = 0.0;
+    for (int a = 0; a < 3; ++a) {
+        Algorithm alg = algs[a];
+        ScheduleCache cache;
+        schedule_cache_init(&cache, 3);
+        schedule_cache_metrics(&cache, &list, alg);
+        double best_add = 1e300, best_edit = 1e300, best_full = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            // A walk-in after the last arrival, taken out again untimed
+            list.items[n] = list.items[n - 1];
+            list.items[n].id = (int)n + 1;
+            list.items[n].arrival_ms += 1;
+            list.count = n + 1;
+            double t0 = now_ms();
+            schedule_cache_added(&cache, &list);
+            sink += schedule_cache_metrics(&cache, &list, alg)->avg_wait_ms;
+            double t1 = now_ms();
+            int *order = schedule_order(&list, alg, 3);
+            if (order) sink += compute_metrics(&list, order, alg, 3).avg_wait_ms;
+            double t2 = now_ms();
+            free(order);
+            Patient before = list.items[n];
+            list.count = n;
+            schedule_cache_removed(&cache, &list, n, &before);
+
+            // A longer visit for the patient in the middle of the arrival order
+            before = list.items[n / 2];
+            list.items[n / 2].required_time_ms += 100;
+            double t3 = now_ms();
+            schedule_cache_changed(&cache, &list, n / 2, &before);
+            sink += schedule_cache_metrics(&cache, &list, alg)->avg_wait_ms;
+            double t4 = now_ms();
+            Patient edited = list.items[n / 2];
+            list.items[n / 2] = before;
+            schedule_cache_changed(&cache, &list, n / 2, &edited);
+
+            if (t1 - t0 < best_add) best_add = t1 - t0;
+            if (t2 - t1 < best_full) best_full = t2 - t1;
+            if (t4 - t3 < best_edit) best_edit = t4 - t3;
+        }
+        char variant[32];
+        snprintf(variant, sizeof(variant), "%s_full", alg_keys[alg]);
+        report("schedule_cache", "recompute", variant, n, best_full);
+        snprintf(variant, sizeof(variant), "%s_patched", alg_keys[alg]);
+        report("schedule_cache", "add_last_arrival", variant, n, best_add);
+        report("schedule_cache", "edit_middle", variant, n, best_edit);
+        schedule_cache_free(&cache);
+    }
+    (void)sink;
+    free_patients(&list);
+}
+
+// 1 if suite is selected by the comma-separated list (NULL selects all)
+static int suite_enabled(const char *suites, const char *name) {
+    if (!suites) return 1;
+    size_t len = strlen(name);
+    for (const char *p = suites; *p; ) {
+        const char *comma = strchr(p, ',');
+        size_t n = comma ? (size_t)(comma - p) : strlen(p);
+        if (n == len && strncmp(p, name, len) == 0) return 1;
+        if (!comma) break;
+        p = comma + 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    size_t max_n = 1000000;
+    int reps = 3;
+    const char *suites = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--max-n") == 0 && i+1 < argc) max_n = (size_t)atol(argv[++i]);
+        else if (strcmp(argv[i], "--reps") == 0 && i+1 < argc) reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--suites") == 0 && i+1 < argc) suites = argv[++i];
+    }
+    if (reps < 1) reps = 1;
+
+    printf("suite,case,variant,n,best_ms,items_per_sec,mb_per_sec\n");
+    if (suite_enabled(suites, "ordering"))
+        for (size_t n = 1000; n <= max_n; n *= 10) bench_ordering(n, reps);
+    if (suite_enabled(suites, "scheduling"))
+        for (size_t n = 1000; n <= max_n; n *= 10) bench_scheduling(n, reps);
+    if (suite_enabled(suites, "layout"))
+        for (size_t n = 1000; n <= max_n; n *= 10) bench_columns(n, reps);
+    if (suite_enabled(suites, "generator"))
+        for (size_t n = 1000; n <= max_n; n *= 10) bench_generator(n, reps);
+    if (suite_enabled(suites, "schedule_cache"))
+        for (size_t n = 1000; n <= max_n; n *= 10) bench_schedule_cache(n, reps);
+    if (suite_enabled(suites, "loader"))
+        for (size_t n = 1000; n <= max_n; n *= 10) bench_loader(n, reps);
+    if (suite_enabled(suites, "log_transport")) bench_log_transport(1000000, reps);
+    if (suite_enabled(suites, "contention")) bench_contention(20000, reps);
+    if (suite_enabled(suites, "gang")) bench_gang(2000, reps);
+    return 0;
+}
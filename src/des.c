@@ -0,0 +1,341 @@
+#include "des.h"
+#include "thread_worker.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Events at the same virtual time are processed SERVICE_END first, so a unit
+// freed at time t can be taken by a patient released at t, as a release in
+// the threaded unit manager grants the next ranked waiter straight away.
+typedef enum {
+    EV_SERVICE_END = 0,   // a patient finished its service or its quantum
+    EV_RELEASE = 1
+} EventKind;
+
+typedef struct {
+    unsigned long long time;
+    int kind;
+    int k;           // position in the scheduled order
+} Event;
+
+typedef struct {
+    Event *items;
+    size_t count;
+} EventHeap;
+
+static int event_before(const Event *a, const Event *b) {
+    if (a->time != b->time) return a->time < b->time;
+    if (a->kind != b->kind) return a->kind < b->kind;
+    return a->k < b->k;
+}
+
+static void heap_push(EventHeap *h, Event ev) {
+    size_t i = h->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!event_before(&ev, &h->items[parent])) break;
+        h->items[i] = h->items[parent];
+        i = parent;
+    }
+    h->items[i] = ev;
+}
+
+static Event heap_pop(EventHeap *h) {
+    Event top = h->items[0];
+    Event last = h->items[--h->count];
+    size_t i = 0;
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        const Event *best = &last;
+        if (l < h->count && event_before(&h->items[l], best)) { m = l; best = &h->items[l]; }
+        if (r < h->count && event_before(&h->items[r], best)) { m = r; }
+        if (m == i) break;
+        h->items[i] = h->items[m];
+        i = m;
+    }
+    if (h->count > 0) h->items[i] = last;
+    return top;
+}
+
+// Per-resource wait queue: a min-heap on rank. Without a quantum the rank is
+// the scheduled position, so waiters are granted in scheduler order. With a
+// quantum it is an enqueue counter, which gives RR's FIFO requeue.
+// Each patient waits on at most one resource at a time, so n slots suffice.
+typedef struct {
+    uint64_t rank;
+    int k;
+} Waiter;
+
+typedef struct {
+    Waiter *items;
+    size_t count;
+    int *free_units;     // stack of idle unit ids, lowest on top
+    int free_count;
+} WaitQueue;
+
+static void wait_push(WaitQueue *q, Waiter w) {
+    size_t i = q->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (q->items[parent].rank <= w.rank) break;
+        q->items[i] = q->items[parent];
+        i = parent;
+    }
+    q->items[i] = w;
+}
+
+static int wait_pop(WaitQueue *q) {
+    Waiter top = q->items[0];
+    Waiter last = q->items[--q->count];
+    size_t i = 0;
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        uint64_t best = last.rank;
+        if (l < q->count && q->items[l].rank < best) { m = l; best = q->items[l].rank; }
+        if (r < q->count && q->items[r].rank < best) { m = r; }
+        if (m == i) break;
+        q->items[i] = q->items[m];
+        i = m;
+    }
+    if (q->count > 0) q->items[i] = last;
+    return top.k;
+}
+
+// Simulation state shared by the event handlers below
+typedef struct {
+    const PatientSource *src;
+    const int *order;
+    ResourcePool *rp;
+    LiveStats *live;
+    unsigned quantum;
+    EventHeap heap;
+    unsigned long long *release;
+    unsigned *remaining;         // of the current stage
+    unsigned *slice;
+    unsigned long long *queued_at;
+    int *unit_of;
+    unsigned char *stage;        // current stage of the pathway
+    unsigned long long *stage_wait;  // [k * MAX_PATH_STEPS + s]: queue time before stage s
+    WaitQueue queues[RESOURCE_TYPE_COUNT];
+    int caps[RESOURCE_TYPE_COUNT];
+    ResourceTotals acct[RESOURCE_TYPE_COUNT];
+    uint64_t enqueue_seq;
+} DesState;
+
+// Patient at scheduled position k; tmp holds it when the source has no rows
+static const Patient *patient_at(const DesState *st, int k, Patient *tmp) {
+    return patient_source_at(st->src, (size_t)st->order[k], tmp);
+}
+
+static PathStep current_step(const DesState *st, int k) {
+    Patient tmp;
+    PathStep steps[MAX_PATH_STEPS];
+    patient_path(patient_at(st, k, &tmp), steps);
+    return steps[st->stage[k]];
+}
+
+// Book the next slice of patient k: the rest of its stage, or one quantum
+static void start_service(DesState *st, unsigned long long now, int k) {
+    unsigned rem = st->remaining[k];
+    st->slice[k] = (st->quantum && rem > st->quantum) ? st->quantum : rem;
+    heap_push(&st->heap, (Event){ .time = now + st->slice[k], .kind = EV_SERVICE_END, .k = k });
+}
+
+static void enqueue(DesState *st, int r, int k, uint64_t rank, unsigned long long now) {
+    st->queued_at[k] = now;
+    wait_push(&st->queues[r], (Waiter){ .rank = rank, .k = k });
+}
+
+// Patient k joins the queue of its current stage's resource
+static void enter_stage(DesState *st, unsigned long long now, int k) {
+    PathStep step = current_step(st, k);
+    int r = (int)resource_type_for_service((ServiceType)step.service);
+    WaitQueue *q = &st->queues[r];
+    st->remaining[k] = step.duration_ms;
+    if (st->live) live_stats_queued(st->live, (ResourceType)r);
+    if (q->free_count > 0) {
+        st->unit_of[k] = q->free_units[--q->free_count];
+        st->acct[r].served++;
+        int held = st->caps[r] - q->free_count;
+        if (held > st->acct[r].max_in_use) st->acct[r].max_in_use = held;
+        if (st->live) live_stats_acquired(st->live, (ResourceType)r, 0);
+        start_service(st, now, k);
+    } else {
+        enqueue(st, r, k, st->quantum ? st->enqueue_seq++ : (uint64_t)k, now);
+    }
+}
+
+// Patient k gave up its unit of resource r: the unit goes straight to the
+// best-ranked waiter, or back to the free list
+static void hand_over(DesState *st, unsigned long long now, int r, int k) {
+    WaitQueue *q = &st->queues[r];
+    if (q->count == 0) {
+        q->free_units[q->free_count++] = st->unit_of[k];
+        return;
+    }
+    int next = wait_pop(q);
+    unsigned long long waited = now - st->queued_at[next];
+    st->unit_of[next] = st->unit_of[k];
+    st->acct[r].wait_ms += waited;
+    st->stage_wait[(size_t)next * MAX_PATH_STEPS + st->stage[next]] += waited;
+    if (st->remaining[next] == current_step(st, next).duration_ms) {
+        st->acct[r].served++;
+        if (st->live) live_stats_acquired(st->live, (ResourceType)r, waited);
+    } else if (st->live) {
+        live_stats_resumed(st->live, (ResourceType)r);
+    }
+    start_service(st, now, next);
+}
+
+void des_default_config(DesConfig *cfg) {
+    cfg->release = DES_RELEASE_ORDER;
+    cfg->launch_gap_ms = 10;
+    cfg->quantum_ms = 0;
+}
+
+int des_run(const PatientSource *src, const int *order, ResourcePool *rp,
+            const DesConfig *cfg, LogRing *log, DesResult *out) {
+    return des_run_detailed(src, order, rp, cfg, log, out, NULL);
+}
+
+static void des_state_free(DesState *st) {
+    free(st->heap.items); free(st->release); free(st->remaining); free(st->slice);
+    free(st->queued_at); free(st->unit_of); free(st->stage); free(st->stage_wait);
+    free(st->queues[0].items); free(st->queues[0].free_units);
+}
+
+int des_run_detailed(const PatientSource *src, const int *order, ResourcePool *rp,
+                     const DesConfig *cfg, LogRing *log, DesResult *out,
+                     unsigned long long *wait_out) {
+    DesResult res = {0};
+    res.critical.k = -1;
+    size_t n = src->count;
+    if (n == 0) { *out = res; return 0; }
+
+    DesConfig def;
+    if (!cfg) { des_default_config(&def); cfg = &def; }
+
+    DesState st = {0};
+    st.src = src;
+    st.order = order;
+    st.rp = rp;
+    st.live = rp->live;
+    st.quantum = cfg->quantum_ms;
+    st.caps[0] = rp->num_doctors; st.caps[1] = rp->num_machines; st.caps[2] = rp->num_rooms;
+    st.heap.items = (Event *)malloc(sizeof(Event) * 2 * n);
+    st.release = (unsigned long long *)malloc(sizeof(unsigned long long) * n);
+    st.remaining = (unsigned *)malloc(sizeof(unsigned) * n);
+    st.slice = (unsigned *)malloc(sizeof(unsigned) * n);
+    st.queued_at = (unsigned long long *)malloc(sizeof(unsigned long long) * n);
+    st.unit_of = (int *)malloc(sizeof(int) * n);
+    st.stage = (unsigned char *)calloc(n, 1);
+    st.stage_wait = (unsigned long long *)calloc(n * MAX_PATH_STEPS, sizeof(unsigned long long));
+    // Each patient waits on at most one resource at a time, so n slots per queue suffice
+    Waiter *queue_mem = (Waiter *)malloc(sizeof(Waiter) * RESOURCE_TYPE_COUNT * n);
+    int *unit_mem = (int *)malloc(sizeof(int) * (size_t)(st.caps[0] + st.caps[1] + st.caps[2]));
+    st.queues[0].items = queue_mem;
+    st.queues[0].free_units = unit_mem;
+    if (!st.heap.items || !st.release || !st.remaining || !st.slice || !st.queued_at ||
+        !st.unit_of || !st.stage || !st.stage_wait || !queue_mem || !unit_mem) {
+        des_state_free(&st);
+        return -1;
+    }
+
+    int *units_next = unit_mem;
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r) {
+        WaitQueue *q = &st.queues[r];
+        q->items = queue_mem + (size_t)r * n;
+        q->count = 0;
+        q->free_units = units_next;
+        q->free_count = st.caps[r];
+        for (int u = 0; u < st.caps[r]; ++u) units_next[u] = st.caps[r] - 1 - u;
+        units_next += st.caps[r];
+    }
+
+    for (size_t k = 0; k < n; ++k) {
+        Patient tmp;
+        const Patient *p = patient_at(&st, (int)k, &tmp);
+        st.release[k] = cfg->release == DES_RELEASE_ARRIVAL
+                      ? (unsigned long long)p->arrival_ms
+                      : (unsigned long long)k * cfg->launch_gap_ms;
+        heap_push(&st.heap, (Event){ .time = st.release[k], .kind = EV_RELEASE, .k = (int)k });
+    }
+
+    double total_wait = 0.0, total_turn = 0.0;
+    unsigned long long now = 0;
+
+    while (st.heap.count > 0) {
+        Event ev = heap_pop(&st.heap);
+        now = ev.time;
+        int k = ev.k;
+        Patient tmp;
+        const Patient *p = patient_at(&st, k, &tmp);
+
+        if (ev.kind == EV_RELEASE) {
+            log_patient_event_at(log, LOG_EVENT_START, p, p->service, now * 1000000ULL);
+            enter_stage(&st, now, k);
+            continue;
+        }
+
+        // EV_SERVICE_END: account the slice, then decide who holds the unit next
+        PathStep step = current_step(&st, k);
+        int r = (int)resource_type_for_service((ServiceType)step.service);
+        st.acct[r].busy_ms += st.slice[k];
+        resources_record_slice(rp, (ResourceType)r, st.unit_of[k], p->id, now - st.slice[k], now);
+        st.remaining[k] -= st.slice[k];
+        if (st.remaining[k] > 0) {
+            // Quantum expired: keep going if nobody waits, else go to the back
+            if (st.queues[r].count == 0) { start_service(&st, now, k); continue; }
+            enqueue(&st, r, k, st.enqueue_seq++, now);
+            if (st.live) live_stats_preempted(st.live, (ResourceType)r);
+            hand_over(&st, now, r, k);
+            continue;
+        }
+
+        hand_over(&st, now, r, k);
+        PathStep steps[MAX_PATH_STEPS];
+        int nsteps = patient_path(p, steps);
+        if (st.stage[k] + 1 < nsteps) {
+            // Pipeline: on to the next stage's queue while this unit serves someone else
+            if (st.live) live_stats_stage_done(st.live, (ResourceType)r, step.duration_ms);
+            st.stage[k]++;
+            enter_stage(&st, now, k);
+            continue;
+        }
+
+        unsigned long long turnaround = now - st.release[k];
+        unsigned long long wait = turnaround - p->required_time_ms;
+        total_turn += (double)turnaround;
+        total_wait += (double)wait;
+        if (wait_out) wait_out[k] = wait;
+        if (st.live) live_stats_released(st.live, (ResourceType)r, step.duration_ms, turnaround);
+        log_patient_event_at(log, LOG_EVENT_FINISH, p, (ServiceType)step.service, now * 1000000ULL);
+
+        // The last patient to finish ends the makespan: its chain is the critical path
+        if (res.critical.k < 0 || now >= res.makespan_ms) {
+            DesCriticalPath *cp = &res.critical;
+            cp->k = (int)k;
+            cp->patient_id = p->id;
+            cp->release_ms = st.release[k];
+            cp->steps = nsteps;
+            for (int s = 0; s < nsteps; ++s) {
+                cp->path[s] = steps[s];
+                cp->wait_ms[s] = st.stage_wait[k * MAX_PATH_STEPS + (size_t)s];
+            }
+            res.makespan_ms = now;
+        }
+    }
+
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r) {
+        resources_merge_totals(rp, (ResourceType)r, &st.acct[r]);
+        res.stage_wait_ms[r] = st.acct[r].served ? (double)st.acct[r].wait_ms / st.acct[r].served : 0.0;
+    }
+
+    res.observed.avg_wait_ms = total_wait / n;
+    res.observed.avg_turnaround_ms = total_turn / n;
+    res.makespan_ms = now;
+    *out = res;
+
+    des_state_free(&st);
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include "dispatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int dispatch_supports(Algorithm alg) {
+    switch (alg) {
+        case ALG_FCFS:
+        case ALG_SJF:
+        case ALG_PRIORITY:
+        case ALG_SRTF:
+        case ALG_PRIORITY_PREEMPTIVE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int dispatch_is_preemptive(Algorithm alg) {
+    return alg == ALG_SRTF || alg == ALG_PRIORITY_PREEMPTIVE;
+}
+
+// Strict ordering of two ready jobs; ties fall back to arrival, then index.
+static int job_before(Algorithm alg, const DispatchJob *a, const DispatchJob *b) {
+    switch (alg) {
+        case ALG_SJF:
+            if (a->burst_ms != b->burst_ms) return a->burst_ms < b->burst_ms;
+            break;
+        case ALG_SRTF:
+            if (a->remaining_ms != b->remaining_ms) return a->remaining_ms < b->remaining_ms;
+            break;
+        case ALG_PRIORITY:
+        case ALG_PRIORITY_PREEMPTIVE:
+            if (a->priority != b->priority) return a->priority < b->priority; // lower value means higher priority
+            break;
+        default:
+            break;
+    }
+    if (a->arrival_ms != b->arrival_ms) return a->arrival_ms < b->arrival_ms;
+    return a->idx < b->idx;
+}
+
+static int heap_push(Dispatcher *d, const DispatchJob *job) {
+    if (d->count == d->cap) {
+        size_t ncap = d->cap ? d->cap * 2 : 64;
+        DispatchJob *nh = (DispatchJob *)realloc(d->heap, sizeof(DispatchJob) * ncap);
+        if (!nh) return -1;
+        d->heap = nh;
+        d->cap = ncap;
+    }
+    size_t i = d->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!job_before(d->alg, job, &d->heap[parent])) break;
+        d->heap[i] = d->heap[parent];
+        i = parent;
+    }
+    d->heap[i] = *job;
+    return 0;
+}
+
+static DispatchJob heap_pop(Dispatcher *d) {
+    DispatchJob top = d->heap[0];
+    DispatchJob last = d->heap[--d->count];
+    size_t i = 0;
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        const DispatchJob *best = &last;
+        if (l < d->count && job_before(d->alg, &d->heap[l], best)) { m = l; best = &d->heap[l]; }
+        if (r < d->count && job_before(d->alg, &d->heap[r], best)) { m = r; }
+        if (m == i) break;
+        d->heap[i] = d->heap[m];
+        i = m;
+    }
+    if (d->count > 0) d->heap[i] = last;
+    return top;
+}
+
+int dispatcher_init(Dispatcher *d, Algorithm alg, const DispatchHooks *hooks) {
+    memset(d, 0, sizeof(*d));
+    if (!dispatch_supports(alg)) return -1;
+    d->alg = alg;
+    if (hooks) d->hooks = *hooks;
+    return 0;
+}
+
+void dispatcher_start_at(Dispatcher *d, unsigned long long now) {
+    d->now = now;
+}
+
+void dispatcher_destroy(Dispatcher *d) {
+    free(d->heap);
+    d->heap = NULL;
+    d->count = d->cap = 0;
+}
+
+static void start_job(Dispatcher *d, DispatchJob job) {
+    if (job.remaining_ms == job.burst_ms && d->hooks.on_start)
+        d->hooks.on_start(d->hooks.ctx, &job, d->now);
+    d->current = job;
+    d->running = 1;
+    d->slice_start = d->now;
+}
+
+static void stop_current(Dispatcher *d) {
+    if (d->now > d->slice_start && d->hooks.on_slice)
+        d->hooks.on_slice(d->hooks.ctx, &d->current, d->slice_start, d->now);
+    d->running = 0;
+}
+
+// Advance the clock to `until`. Decisions are only taken strictly before
+// `until` (or at any time when draining) so that all arrivals at a given
+// instant are in the ready queue before the server picks among them.
+static int advance(Dispatcher *d, unsigned long long until, int drain) {
+    for (;;) {
+        if (!d->running) {
+            if (d->count == 0) {
+                if (!drain && until > d->now) d->now = until;
+                return 0;
+            }
+            if (!drain && d->now >= until) return 0;
+            start_job(d, heap_pop(d));
+        } else if (dispatch_is_preemptive(d->alg) && d->count > 0 &&
+                   (drain || d->now < until) &&
+                   job_before(d->alg, &d->heap[0], &d->current)) {
+            stop_current(d);
+            if (heap_push(d, &d->current) != 0) return -1;
+            continue;
+        }
+
+        unsigned long long finish = d->now + d->current.remaining_ms;
+        if (drain || finish <= until) {
+            d->now = finish;
+            d->current.remaining_ms = 0;
+            stop_current(d);
+            if (d->hooks.on_finish) d->hooks.on_finish(d->hooks.ctx, &d->current, finish);
+            continue;
+        }
+        d->current.remaining_ms -= (unsigned)(until - d->now);
+        d->now = until;
+        return 0;
+    }
+}
+
+int dispatcher_arrive(Dispatcher *d, const DispatchJob *job) {
+    if (advance(d, job->arrival_ms, 0) != 0) return -1;
+    return heap_push(d, job);
+}
+
+void dispatcher_drain(Dispatcher *d) {
+    advance(d, 0, 1);
+}
+
+int dispatch_run_columns(const PatientColumns *cols, Algorithm alg, const DispatchHooks *hooks) {
+    Dispatcher d;
+    if (dispatcher_init(&d, alg, hooks) != 0) return -1;
+    if (cols->count == 0) return 0;
+
+    // Feed arrivals in arrival order
+    int *arrival_order = schedule_order_columns(cols, ALG_FCFS, 0);
+    if (!arrival_order) return -1;
+
+    int rc = 0;
+    for (size_t k = 0; k < cols->count && rc == 0; ++k) {
+        int i = arrival_order[k];
+        DispatchJob job = {
+            .idx = i,
+            .id = cols->id ? cols->id[i] : i,
+            .arrival_ms = cols->arrival_ms[i],
+            .burst_ms = cols->burst_ms[i],
+            .remaining_ms = cols->burst_ms[i],
+            .priority = cols->priority[i]
+        };
+        rc = dispatcher_arrive(&d, &job);
+    }
+    if (rc == 0) dispatcher_drain(&d);
+
+    free(arrival_order);
+    dispatcher_destroy(&d);
+    return rc;
+}
+
+int dispatch_run_list(const PatientList *list, Algorithm alg, const DispatchHooks *hooks) {
+    PatientColumns cols;
+    if (patient_columns_build(list, &cols, 0) != 0) return -1;
+    int rc = dispatch_run_columns(&cols, alg, hooks);
+    patient_columns_free(&cols);
+    return rc;
+}
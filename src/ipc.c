@@ -1,4 +1,7 @@
-// Ensure POSIX prototypes (ftruncate) are visible
+// Ensure POSIX prototypes (ftruncate) and syscall() are visible
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #ifndef _POSIX_C_SOURCE
 #define _POSIX_C_SOURCE 200809L
 #endif
@@ -8,7 +11,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <signal.h>
 #include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 int ipc_setup_fifo() {
     // Create named FIFO; ignore EEXIST
@@ -52,6 +60,11 @@ int ipc_close_mq(mqd_t mq) {
     return 0;
 }
 
+int ipc_cleanup_mq() {
+    mq_unlink(MQ_NAME);
+    return 0;
+}
+
 int ipc_setup_shm(int *fd, SharedStats **stats_ptr, int create) {
     int flags = create ? (O_CREAT | O_RDWR) : O_RDWR;
     int shm_fd = shm_open(SHM_NAME, flags, 0666);
@@ -81,3 +94,151 @@ int ipc_cleanup_shm() {
     shm_unlink(SHM_NAME);
     return 0;
 }
+
+void shared_stats_write(SharedStats *stats, const SharedStatsData *data) {
+    uint32_t seq = atomic_load_explicit(&stats->seq, memory_order_relaxed);
+    atomic_store_explicit(&stats->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&stats->data, data, sizeof(*data));
+    atomic_store_explicit(&stats->seq, seq + 2, memory_order_release);
+}
+
+void shared_stats_read(const SharedStats *stats, SharedStatsData *out) {
+    SharedStats *s = (SharedStats *)stats;
+    for (;;) {
+        uint32_t before = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (before & 1) { sched_yield(); continue; }
+        memcpy(out, &stats->data, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&s->seq, memory_order_relaxed) == before) return;
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Shared-memory log ring
+// ─────────────────────────────────────────────────────────────────────────────
+int ipc_setup_log_ring(int *fd, ShmLogRing **ring_ptr, int create) {
+    int flags = create ? (O_CREAT | O_RDWR) : O_RDWR;
+    int shm_fd = shm_open(SHM_LOG_NAME, flags, 0666);
+    if (shm_fd == -1) {
+        perror("shm_open log ring");
+        return -1;
+    }
+    if (create && ftruncate(shm_fd, (off_t)sizeof(ShmLogRing)) == -1) {
+        perror("ftruncate log ring");
+        close(shm_fd);
+        return -1;
+    }
+    void *addr = mmap(NULL, sizeof(ShmLogRing), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (addr == MAP_FAILED) {
+        perror("mmap log ring");
+        close(shm_fd);
+        return -1;
+    }
+    ShmLogRing *ring = (ShmLogRing *)addr;
+    if (create) {
+        // A fresh object is zero-filled; reset in case a stale one was reused
+        atomic_store(&ring->head, 0);
+        atomic_store(&ring->tail, 0);
+        atomic_store(&ring->futex, 0);
+        atomic_store(&ring->waiting, 0);
+        atomic_store(&ring->closed, 0);
+        atomic_store(&ring->abandoned, 0);
+        atomic_store(&ring->consumer_pid, 0);
+        ring->capacity = SHM_LOG_CAPACITY;
+    } else {
+        atomic_store(&ring->consumer_pid, (int32_t)getpid());
+    }
+    *fd = shm_fd;
+    *ring_ptr = ring;
+    return 0;
+}
+
+void ipc_close_log_ring(int fd, ShmLogRing *ring) {
+    if (ring) munmap(ring, sizeof(*ring));
+    if (fd != -1) close(fd);
+}
+
+int ipc_cleanup_log_ring() {
+    shm_unlink(SHM_LOG_NAME);
+    return 0;
+}
+
+// Shared (not FUTEX_PRIVATE) operations: the waiter is another process
+static void futex_wake(_Atomic uint32_t *addr) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static void futex_wait(_Atomic uint32_t *addr, uint32_t val, unsigned timeout_ms) {
+    struct timespec ts = { .tv_sec = timeout_ms / 1000, .tv_nsec = (long)(timeout_ms % 1000) * 1000000L };
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static void shm_log_publish(ShmLogRing *ring, uint64_t tail) {
+    atomic_store(&ring->tail, tail);
+    atomic_fetch_add(&ring->futex, 1);
+    if (atomic_load(&ring->waiting)) futex_wake(&ring->futex);
+}
+
+// The consumer process has exited. A logger that died as our unreaped
+// child still answers kill(0), so the stall timeout covers that case.
+static int consumer_gone(const ShmLogRing *ring) {
+    pid_t pid = (pid_t)atomic_load(&((ShmLogRing *)ring)->consumer_pid);
+    return pid > 0 && kill(pid, 0) == -1 && errno == ESRCH;
+}
+
+int shm_log_write(ShmLogRing *ring, const LogRecord *recs, size_t n) {
+    uint64_t mask = ring->capacity - 1;
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t last_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    unsigned stalled_ms = 0;
+    while (n > 0) {
+        if (atomic_load_explicit(&ring->abandoned, memory_order_relaxed)) return -1;
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        size_t space = ring->capacity - (size_t)(tail - head);
+        if (space == 0) {
+            // Logger is behind on disk writes; it frees space without waking us
+            if (head != last_head) {
+                last_head = head;
+                stalled_ms = 0;
+            }
+            if (stalled_ms >= SHM_LOG_STALL_MS || consumer_gone(ring)) {
+                atomic_store(&ring->abandoned, 1);
+                fprintf(stderr, "log ring: logger stopped consuming; dropping further log records\n");
+                return -1;
+            }
+            struct timespec ts = { 0, 1000000L };
+            nanosleep(&ts, NULL);
+            stalled_ms++;
+            continue;
+        }
+        size_t chunk = n < space ? n : space;
+        size_t first = ring->capacity - (size_t)(tail & mask);
+        if (first > chunk) first = chunk;
+        memcpy(&ring->records[tail & mask], recs, first * sizeof(LogRecord));
+        memcpy(&ring->records[0], recs + first, (chunk - first) * sizeof(LogRecord));
+        tail += chunk;
+        recs += chunk;
+        n -= chunk;
+        shm_log_publish(ring, tail);
+    }
+    return 0;
+}
+
+void shm_log_close(ShmLogRing *ring) {
+    atomic_store(&ring->closed, 1);
+    atomic_fetch_add(&ring->futex, 1);
+    futex_wake(&ring->futex);
+}
+
+size_t shm_log_wait(ShmLogRing *ring, size_t have, unsigned timeout_ms) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t seen = atomic_load(&ring->futex);
+    atomic_store(&ring->waiting, 1);
+    // Re-check after announcing: a publish after this point changes the futex
+    // word, so FUTEX_WAIT returns at once instead of missing the wakeup.
+    if (atomic_load(&ring->tail) - head <= have && !atomic_load(&ring->closed))
+        futex_wait(&ring->futex, seen, timeout_ms);
+    atomic_store(&ring->waiting, 0);
+    return (size_t)(atomic_load_explicit(&ring->tail, memory_order_acquire) - head);
+}
@@ -0,0 +1,118 @@
+#include "common.h"
+#include "livestats.h"
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void atomic_max(_Atomic uint64_t *dst, uint64_t v) {
+    uint64_t cur = atomic_load_explicit(dst, memory_order_relaxed);
+    while (v > cur && !atomic_compare_exchange_weak_explicit(dst, &cur, v, memory_order_relaxed,
+                                                             memory_order_relaxed)) {}
+}
+
+void live_stats_queued(LiveStats *ls, ResourceType r) {
+    atomic_fetch_add_explicit(&ls->queue_depth[r], 1, memory_order_relaxed);
+}
+
+void live_stats_acquired(LiveStats *ls, ResourceType r, uint64_t wait_ms) {
+    atomic_fetch_sub_explicit(&ls->queue_depth[r], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ls->in_flight[r], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ls->wait_hist[hist_bucket(wait_ms)], 1, memory_order_relaxed);
+    atomic_max(&ls->wait_max, wait_ms);
+}
+
+void live_stats_preempted(LiveStats *ls, ResourceType r) {
+    atomic_fetch_sub_explicit(&ls->in_flight[r], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ls->queue_depth[r], 1, memory_order_relaxed);
+}
+
+void live_stats_resumed(LiveStats *ls, ResourceType r) {
+    atomic_fetch_sub_explicit(&ls->queue_depth[r], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ls->in_flight[r], 1, memory_order_relaxed);
+}
+
+void live_stats_abandoned(LiveStats *ls, ResourceType r) {
+    atomic_fetch_sub_explicit(&ls->queue_depth[r], 1, memory_order_relaxed);
+}
+
+void live_stats_stage_done(LiveStats *ls, ResourceType r, uint64_t busy_ms) {
+    atomic_fetch_sub_explicit(&ls->in_flight[r], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ls->busy_ms[r], busy_ms, memory_order_relaxed);
+}
+
+void live_stats_released(LiveStats *ls, ResourceType r, uint64_t busy_ms, uint64_t turnaround_ms) {
+    live_stats_stage_done(ls, r, busy_ms);
+    atomic_fetch_add_explicit(&ls->turn_hist[hist_bucket(turnaround_ms)], 1, memory_order_relaxed);
+    atomic_max(&ls->turn_max, turnaround_ms);
+    atomic_fetch_add_explicit(&ls->completed, 1, memory_order_relaxed);
+}
+
+void live_stats_snapshot(LiveStats *ls, SharedStatsData *out) {
+    *out = ls->base;
+    out->completed_jobs = (int)atomic_load_explicit(&ls->completed, memory_order_relaxed);
+    out->running = !atomic_load_explicit(&ls->stop, memory_order_relaxed);
+    out->elapsed_ms = (monotonic_ns() - ls->start_ns) / 1000000ULL;
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r) {
+        out->in_flight[r] = atomic_load_explicit(&ls->in_flight[r], memory_order_relaxed);
+        out->queue_depth[r] = atomic_load_explicit(&ls->queue_depth[r], memory_order_relaxed);
+        out->busy_ms[r] = atomic_load_explicit(&ls->busy_ms[r], memory_order_relaxed);
+    }
+    for (unsigned b = 0; b < HIST_BUCKETS; ++b) {
+        out->wait_ms.counts[b] = atomic_load_explicit(&ls->wait_hist[b], memory_order_relaxed);
+        out->turnaround_ms.counts[b] = atomic_load_explicit(&ls->turn_hist[b], memory_order_relaxed);
+        out->wait_ms.total += out->wait_ms.counts[b];
+        out->turnaround_ms.total += out->turnaround_ms.counts[b];
+    }
+    out->wait_ms.max = atomic_load_explicit(&ls->wait_max, memory_order_relaxed);
+    out->turnaround_ms.max = atomic_load_explicit(&ls->turn_max, memory_order_relaxed);
+}
+
+static void *publisher_main(void *arg) {
+    LiveStats *ls = (LiveStats *)arg;
+    SharedStatsData snap;
+    while (!atomic_load_explicit(&ls->stop, memory_order_acquire)) {
+        live_stats_snapshot(ls, &snap);
+        shared_stats_write(ls->page, &snap);
+        ms_sleep(ls->period_ms);
+    }
+    return NULL;
+}
+
+int live_stats_init(LiveStats *ls, SharedStats *page, const ScheduleMetrics *predicted,
+                    int total_jobs, unsigned period_ms) {
+    memset(ls, 0, sizeof(*ls));
+    ls->page = page;
+    ls->base.total_jobs = total_jobs;
+    if (predicted) {
+        ls->base.avg_wait_ms = predicted->avg_wait_ms;
+        ls->base.avg_turnaround_ms = predicted->avg_turnaround_ms;
+    }
+    ls->start_ns = monotonic_ns();
+    ls->period_ms = period_ms ? period_ms : LIVE_STATS_PERIOD_MS;
+    atomic_init(&ls->stop, 0);
+    if (!page) return 0;
+
+    SharedStatsData snap;
+    live_stats_snapshot(ls, &snap);
+    shared_stats_write(page, &snap);
+    if (pthread_create(&ls->publisher, NULL, publisher_main, ls) != 0) {
+        perror("pthread_create stats publisher");
+        return -1;
+    }
+    ls->publishing = 1;
+    return 0;
+}
+
+void live_stats_destroy(LiveStats *ls) {
+    atomic_store_explicit(&ls->stop, 1, memory_order_release);
+    if (ls->publishing) pthread_join(ls->publisher, NULL);
+    ls->publishing = 0;
+    if (ls->page) {
+        SharedStatsData snap;
+        live_stats_snapshot(ls, &snap);
+        shared_stats_write(ls->page, &snap);
+    }
+}
@@ -0,0 +1,34 @@
+// Decode the binary patient-event log written by the logger.
+// Usage: bin/logdump [--csv] [path]   (default path: logs/log.bin)
+#include "common.h"
+#include "logfmt.h"
+
+int main(int argc, char **argv) {
+    const char *path = LOG_BIN_PATH;
+    int csv = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--csv") == 0) csv = 1;
+        else path = argv[i];
+    }
+
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+
+    if (csv) printf("run,time_ms,event,patient_id,service,resource\n");
+    LogRecord recs[1024];
+    LogDecoder dec = {0};
+    char line[160];
+    size_t n;
+    while ((n = fread(recs, sizeof(LogRecord), 1024, in)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            if (log_format_record(&dec, &recs[i], csv, line, sizeof(line)) && csv) continue;
+            puts(line);
+        }
+    }
+    if (ferror(in)) perror("read");
+    fclose(in);
+    return 0;
+}
@@ -1,13 +1,88 @@
-// Enable POSIX features (must be before any includes)
+// Enable POSIX/GNU features (must be before any includes; fallocate is GNU)
+#define _GNU_SOURCE
 #define _POSIX_C_SOURCE 200809L
 
 #include "ipc.h"
 #include "common.h"
+#include "logfmt.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
 #include <pthread.h>
+#include <stdatomic.h>
+
+#define LOG_READ_BUF (64 * 1024)               // bytes gathered before each disk write
+#define LOG_PREALLOC_CHUNK (4 * 1024 * 1024)   // disk space reserved ahead of the writer
+#define LOG_IDLE_FLUSH_MS 50                   // write a partial buffer after this much quiet
+
+// Append-only binary log. Space is reserved in chunks with FALLOC_FL_KEEP_SIZE,
+// so the file size only ever covers complete writes.
+typedef struct {
+    int fd;
+    off_t end;        // bytes written so far
+    off_t reserved;   // bytes preallocated
+} BinLog;
+
+static int binlog_open(BinLog *log, const char *path) {
+    log->fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (log->fd == -1) {
+        perror("open binary log");
+        return -1;
+    }
+    log->end = lseek(log->fd, 0, SEEK_END);
+    if (log->end < 0) log->end = 0;
+    log->reserved = log->end;
+    return 0;
+}
+
+static void binlog_append(BinLog *log, const char *buf, size_t len) {
+    if (len == 0) return;
+    uint64_t t_trace = trace_begin();
+    size_t total = len;
+    if (log->end + (off_t)len > log->reserved) {
+        // Best effort: filesystems without fallocate just grow on write
+        if (fallocate(log->fd, FALLOC_FL_KEEP_SIZE, log->reserved, LOG_PREALLOC_CHUNK) == 0)
+            log->reserved += LOG_PREALLOC_CHUNK;
+        else
+            log->reserved = log->end + (off_t)len;
+    }
+    while (len > 0) {
+        ssize_t w = write(log->fd, buf, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            perror("write binary log");
+            return;
+        }
+        buf += w;
+        len -= (size_t)w;
+        log->end += w;
+    }
+    trace_end("disk write", t_trace, "bytes", (int64_t)total);
+}
+
+// Set once the log transport has been drained; the MQ reader then exits as
+// soon as its queue is empty.
+static atomic_int g_transport_done;
+
+static void write_report(FILE *out, const SharedStatsData *s) {
+    static const char *names[RESOURCE_TYPE_COUNT] = { "Doctor", "Machine", "Room" };
+    fprintf(out, "\nFinal Report:\n");
+    fprintf(out, "Average Waiting Time: %.2f ms\n", s->avg_wait_ms);
+    fprintf(out, "Average Turnaround Time: %.2f ms\n", s->avg_turnaround_ms);
+    fprintf(out, "Completed Jobs: %d\n", s->completed_jobs);
+    fprintf(out, "Observed Wait p50/p95/p99/max: %llu/%llu/%llu/%llu ms\n",
+            (unsigned long long)hist_percentile(&s->wait_ms, 0.50),
+            (unsigned long long)hist_percentile(&s->wait_ms, 0.95),
+            (unsigned long long)hist_percentile(&s->wait_ms, 0.99),
+            (unsigned long long)s->wait_ms.max);
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r)
+        fprintf(out, "%s Busy: %llu ms\n", names[r], (unsigned long long)s->busy_ms[r]);
+    fflush(out);
+}
 
 static void *mq_reader(void *arg) {
     FILE *out = (FILE *)arg;
@@ -17,57 +92,135 @@ static void *mq_reader(void *arg) {
     char msg[MQ_MSG_MAX];
     unsigned prio;
     while (1) {
-        ssize_t n = mq_receive(mq, msg, sizeof(msg), &prio);
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += 100 * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) { deadline.tv_sec++; deadline.tv_nsec -= 1000000000L; }
+        ssize_t n = mq_timedreceive(mq, msg, sizeof(msg), &prio, &deadline);
         if (n >= 0) {
             msg[n] = '\0';
             fprintf(out, "[MQ] %s\n", msg);
             fflush(out);
             if (strcmp(msg, "STATS_READY") == 0) {
-                // Read shared memory stats
+                // Read a consistent snapshot of the shared stats page
                 int fd = -1; SharedStats *stats = NULL;
                 if (ipc_setup_shm(&fd, &stats, 0) == 0) {
-                    fprintf(out, "\nFinal Report:\n");
-                    fprintf(out, "Average Waiting Time: %.2f ms\n", stats->avg_wait_ms);
-                    fprintf(out, "Average Turnaround Time: %.2f ms\n", stats->avg_turnaround_ms);
-                    fprintf(out, "Completed Jobs: %d\n", stats->completed_jobs);
-                    fflush(out);
+                    SharedStatsData snap;
+                    shared_stats_read(stats, &snap);
+                    write_report(out, &snap);
                     munmap(stats, sizeof(*stats));
                     close(fd);
                 }
-                // After stats, continue reading until FIFO ends; do not exit here
             }
+        } else if (errno == ETIMEDOUT) {
+            if (atomic_load(&g_transport_done)) break;
         } else {
             // MQ error; sleep and retry
             ms_sleep(100);
+            if (atomic_load(&g_transport_done)) break;
         }
     }
     ipc_close_mq(mq);
     return NULL;
 }
 
-int main(void) {
-    // Open FIFO for reading
+// The FIFO carries LogRecords from a single writer, so the byte stream is
+// appended as-is: gather up to LOG_READ_BUF, then one write to disk.
+static int drain_fifo(BinLog *bin) {
     int fifo_fd = open(FIFO_PATH, O_RDONLY);
     if (fifo_fd == -1) {
         perror("open FIFO");
-        return 1;
+        return -1;
+    }
+    static char buf[LOG_READ_BUF];
+    size_t used = 0;
+    struct pollfd pfd = { .fd = fifo_fd, .events = POLLIN };
+    for (;;) {
+        uint64_t t_trace = trace_begin();
+        int ready = poll(&pfd, 1, LOG_IDLE_FLUSH_MS);
+        trace_end("fifo wait", t_trace, NULL, 0);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready == 0) {
+            if (used > 0) { binlog_append(bin, buf, used); used = 0; }
+            continue;
+        }
+        ssize_t n = read(fifo_fd, buf + used, sizeof(buf) - used);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        used += (size_t)n;
+        if (used == sizeof(buf)) { binlog_append(bin, buf, used); used = 0; }
     }
+    if (used > 0) binlog_append(bin, buf, used);
+    close(fifo_fd);
+    return 0;
+}
+
+// Shared-memory transport: records are written to disk straight from the
+// mapping. Small bursts accumulate until LOG_READ_BUF worth of records is
+// ready or the producer goes quiet for LOG_IDLE_FLUSH_MS.
+static int drain_shm(BinLog *bin) {
+    int fd = -1; ShmLogRing *ring = NULL;
+    if (ipc_setup_log_ring(&fd, &ring, 0) != 0) return -1;
+    const size_t batch = LOG_READ_BUF / sizeof(LogRecord);
+    uint64_t mask = ring->capacity - 1;
+    uint64_t head = atomic_load(&ring->head);
+    size_t pending = 0;
+    for (;;) {
+        uint64_t t_trace = trace_begin();
+        size_t avail = shm_log_wait(ring, pending, LOG_IDLE_FLUSH_MS);
+        trace_end("ring wait", t_trace, "records", (int64_t)avail);
+        int closed = atomic_load(&ring->closed) != 0;
+        // Everything published before `closed` is visible now
+        if (closed) avail = (size_t)(atomic_load(&ring->tail) - head);
+        int idle = avail == pending;
+        if (avail > 0 && (avail >= batch || idle || closed)) {
+            size_t first = ring->capacity - (size_t)(head & mask);
+            if (first > avail) first = avail;
+            binlog_append(bin, (const char *)&ring->records[head & mask], first * sizeof(LogRecord));
+            binlog_append(bin, (const char *)&ring->records[0], (avail - first) * sizeof(LogRecord));
+            head += avail;
+            atomic_store_explicit(&ring->head, head, memory_order_release);
+            avail = 0;
+        }
+        pending = avail;
+        if (closed && pending == 0) break;
+    }
+    ipc_close_log_ring(fd, ring);
+    return 0;
+}
+
+// Usage: logger [--transport fifo|shm] [--trace fragment]
+// With --trace, the drain loop is traced and its events are written to
+// `fragment` at exit for the scheduler to merge into its trace file.
+int main(int argc, char **argv) {
+    int use_shm = 0;
+    const char *trace_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--transport") == 0 && i+1 < argc) use_shm = strcmp(argv[++i], "shm") == 0;
+        else if (strcmp(argv[i], "--trace") == 0 && i+1 < argc) trace_path = argv[++i];
+    }
+    if (trace_path) {
+        trace_start("logger");
+        trace_thread_name("drain");
+    }
+
     FILE *out = fopen("logs/log.txt", "a");
     if (!out) out = stdout;
+    BinLog bin;
+    if (binlog_open(&bin, LOG_BIN_PATH) != 0) return 1;
 
     pthread_t th;
-    pthread_create(&th, NULL, mq_reader, out);
-
-    char buf[256];
-    ssize_t n;
-    while ((n = read(fifo_fd, buf, sizeof(buf)-1)) > 0) {
-        buf[n] = '\0';
-        fprintf(out, "%s", buf);
-        fflush(out);
-    }
+    int mq_started = pthread_create(&th, NULL, mq_reader, out) == 0;
 
-    // FIFO closed: cleanup and exit
+    int rc = use_shm ? drain_shm(&bin) : drain_fifo(&bin);
+
+    // Messages sent before the transport closed are still handled
+    atomic_store(&g_transport_done, 1);
+    if (mq_started) pthread_join(th, NULL);
+
+    // Transport closed: cleanup and exit
     // Keep 'out' open until process exit to avoid races with MQ thread.
-    close(fifo_fd);
-    return 0;
+    close(bin.fd);
+    if (trace_path) trace_write_fragment(trace_path);
+    return rc == 0 ? 0 : 1;
 }
@@ -0,0 +1,125 @@
+#include "common.h"
+#include "logring.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void log_ring_push_at(LogRing *ring, LogEvent event, int patient_id, ServiceType service,
+                      uint64_t ts_ns) {
+    size_t pos = atomic_fetch_add_explicit(&ring->tail, 1, memory_order_relaxed);
+    LogSlot *slot = &ring->slots[pos & ring->mask];
+    // The slot is free once the flusher has released it for this lap
+    while (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos) sched_yield();
+    slot->rec = (LogRecord){
+        .ts_ns = ts_ns,
+        .patient_id = patient_id,
+        .event = (uint8_t)event,
+        .service = (uint8_t)service,
+        .resource = (uint8_t)resource_type_for_service(service)
+    };
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+}
+
+void log_ring_push(LogRing *ring, LogEvent event, int patient_id, ServiceType service) {
+    log_ring_push_at(ring, event, patient_id, service, monotonic_ns());
+}
+
+// Write the whole buffer; the UI opens the FIFO non-blocking, so EAGAIN means
+// the logger is behind and we retry after a short pause.
+static void write_all(int fd, const void *buf, size_t len) {
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) { ms_sleep(1); continue; }
+            perror("write log");
+            return;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+}
+
+static void send_records(const LogTransport *out, const LogRecord *recs, size_t n) {
+    if (out->shm) shm_log_write(out->shm, recs, n);
+    else write_all(out->fd, recs, sizeof(LogRecord) * n);
+}
+
+// Drain up to one batch; returns the number of records written.
+static int flush_batch(LogRing *ring) {
+    LogRecord batch[LOG_RING_BATCH];
+    int cnt = 0;
+    while (cnt < LOG_RING_BATCH) {
+        LogSlot *slot = &ring->slots[ring->head & ring->mask];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != ring->head + 1) break;
+        batch[cnt++] = slot->rec;
+        // Hand the slot back to producers for the next lap
+        atomic_store_explicit(&slot->seq, ring->head + ring->mask + 1, memory_order_release);
+        ring->head++;
+    }
+    if (cnt > 0) {
+        uint64_t t_trace = trace_begin();
+        send_records(&ring->out, batch, (size_t)cnt);
+        trace_end("log send", t_trace, "records", cnt);
+    }
+    return cnt;
+}
+
+static void *flusher_main(void *arg) {
+    LogRing *ring = (LogRing *)arg;
+    trace_thread_name("log flusher");
+    for (;;) {
+        int stopping = atomic_load_explicit(&ring->stop, memory_order_acquire);
+        if (flush_batch(ring) > 0) continue;
+        // Producers have finished before stop is set, so an empty ring is final
+        if (stopping) break;
+        ms_sleep(1);
+    }
+    return NULL;
+}
+
+int log_ring_init(LogRing *ring, const LogTransport *out, size_t capacity, LogClock clock) {
+    size_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+    ring->slots = (LogSlot *)malloc(sizeof(LogSlot) * cap);
+    if (!ring->slots) return -1;
+    for (size_t i = 0; i < cap; ++i) atomic_init(&ring->slots[i].seq, i);
+    ring->mask = cap - 1;
+    atomic_init(&ring->tail, 0);
+    ring->head = 0;
+    ring->out = *out;
+    atomic_init(&ring->stop, 0);
+
+    LogRecord header = {
+        .ts_ns = clock == LOG_CLOCK_VIRTUAL ? 0 : monotonic_ns(),
+        .patient_id = LOG_FORMAT_VERSION,
+        .event = LOG_EVENT_RUN,
+        .resource = (uint8_t)clock
+    };
+    send_records(out, &header, 1);
+
+    if (pthread_create(&ring->flusher, NULL, flusher_main, ring) != 0) {
+        perror("pthread_create log flusher");
+        free(ring->slots);
+        ring->slots = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void log_ring_destroy(LogRing *ring) {
+    if (!ring->slots) return;
+    atomic_store_explicit(&ring->stop, 1, memory_order_release);
+    pthread_join(ring->flusher, NULL);
+    free(ring->slots);
+    ring->slots = NULL;
+}
@@ -4,122 +4,631 @@
 #include "resources.h"
 #include "thread_worker.h"
 #include "ipc.h"
+#include "des.h"
+#include "sweep.h"
+#include "livestats.h"
+#include "storage.h"
+#include "snapshot.h"
+#include "stream.h"
+#include "workload.h"
+#include "trace.h"
 
+#include <limits.h>
+#include <signal.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/wait.h>
 
+// Returns 0 and sets *out, or -1 for an unknown name
+static int lookup_alg(const char *s, Algorithm *out) {
+    static const struct { const char *name; Algorithm alg; } names[] = {
+        { "fcfs", ALG_FCFS }, { "sjf", ALG_SJF }, { "priority", ALG_PRIORITY }, { "rr", ALG_RR },
+        { "srtf", ALG_SRTF }, { "ppriority", ALG_PRIORITY_PREEMPTIVE }
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+        if (strcmp(s, names[i].name) == 0) { *out = names[i].alg; return 0; }
+    return -1;
+}
+
+// Unknown names fall back to FCFS
 static Algorithm parse_alg(const char *s) {
-    if (strcmp(s, "fcfs") == 0) return ALG_FCFS;
-    if (strcmp(s, "sjf") == 0) return ALG_SJF;
-    if (strcmp(s, "priority") == 0) return ALG_PRIORITY;
-    if (strcmp(s, "rr") == 0) return ALG_RR;
-    return ALG_FCFS;
+    Algorithm alg = ALG_FCFS;
+    lookup_alg(s, &alg);
+    return alg;
+}
+
+typedef enum {
+    MODE_THREADS = 0,
+    MODE_DES = 1
+} RunMode;
+
+typedef enum {
+    TRANSPORT_FIFO = 0,
+    TRANSPORT_SHM = 1
+} LogTransportKind;
+
+static RunMode parse_mode(const char *s) {
+    if (strcmp(s, "des") == 0) return MODE_DES;
+    return MODE_THREADS;
+}
+
+// Copy a parsed --doctors/--machines/... list into dst; -1 if malformed.
+static int parse_values(const char *opt, const char *s, int *dst, size_t *count) {
+    int n = sweep_parse_list(s, dst);
+    if (n < 0) {
+        fprintf(stderr, "%s: expected comma-separated positive integers (at most %d)\n", opt, SWEEP_MAX_VALUES);
+        return -1;
+    }
+    *count = (size_t)n;
+    return 0;
+}
+
+// "Label p50/p95/p99/max: a/b/c/d ms (n patients)"; nothing for an empty class
+static void print_latency(const char *label, const LatencySummary *l) {
+    if (l->count == 0) return;
+    printf("%s p50/p95/p99/max: %llu/%llu/%llu/%llu ms (%llu patients)\n", label,
+           (unsigned long long)l->p50, (unsigned long long)l->p95, (unsigned long long)l->p99,
+           (unsigned long long)l->max, (unsigned long long)l->count);
+}
+
+// Map path as a snapshot. Errors are reported as "path: message".
+static int open_snapshot(const char *path, Snapshot *snap) {
+    char err[128];
+    if (snapshot_open(path, snap, err, sizeof(err)) == 0) return 0;
+    fprintf(stderr, "%s: %s\n", path, err);
+    return -1;
+}
+
+// Materialize an open snapshot's rows into list, for code that needs a
+// PatientList (worker pool, pathway rewrite, CSV export), and close it.
+static int snapshot_rows(const char *path, Snapshot *snap, PatientList *list) {
+    int rc = snapshot_to_list(snap, list);
+    if (rc != 0) fprintf(stderr, "%s: out of memory\n", path);
+    snapshot_close(snap);
+    return rc;
+}
+
+static int load_snapshot(const char *path, PatientList *list) {
+    Snapshot snap;
+    if (open_snapshot(path, &snap) != 0) return -1;
+    return snapshot_rows(path, &snap, list);
+}
+
+// "path: skipped N malformed lines (...)" on stderr when a CSV load skipped any
+static void report_skips(const char *path, const CsvError *err) {
+    char buf[256];
+    csv_format_skips(err, buf, sizeof(buf));
+    if (buf[0]) fprintf(stderr, "%s: %s\n", path, buf);
+}
+
+// Patients from a CSV file or .hrs snapshot when path is set, else n generated
+// from wcfg. CSV load errors are reported as "path:line: message". A snapshot
+// is only mapped: it stays open in *snap with list left empty (see
+// snapshot_rows); otherwise snap->map is NULL.
+static int load_or_create(const char *path, int n, const WorkloadConfig *wcfg, PatientList *list, Snapshot *snap) {
+    memset(snap, 0, sizeof(*snap));
+    list->items = NULL;
+    list->count = 0;
+    if (!path) {
+        if (generate_patients(wcfg, (size_t)(n > 0 ? n : 0), list) == 0) return 0;
+        fprintf(stderr, "Cannot generate %d patients (out of memory or arrivals past 2^32 ms)\n", n);
+        return -1;
+    }
+    if (snapshot_is_path(path)) return open_snapshot(path, snap);
+    CsvError err;
+    if (load_patients_csv_ex(path, list, &err) == 0) {
+        report_skips(path, &err);
+        return 0;
+    }
+    if (err.line) fprintf(stderr, "%s:%zu: %s\n", path, err.line, err.msg);
+    else fprintf(stderr, "%s: %s\n", path, err.msg);
+    return -1;
+}
+
+// hospital_scheduler import in.csv out.hrs / export in.hrs out.csv: convert
+// between the CSV layout and binary snapshots.
+static int convert_main(int argc, char **argv) {
+    int import = strcmp(argv[1], "import") == 0;
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s %s %s\n", argv[0], argv[1],
+                import ? "<in.csv> <out.hrs>" : "<in.hrs> <out.csv>");
+        return 1;
+    }
+    PatientList list;
+    if (import) {
+        CsvError err;
+        if (load_patients_csv_mt(argv[2], &list, &err, 0) != 0) {
+            if (err.line) fprintf(stderr, "%s:%zu: %s\n", argv[2], err.line, err.msg);
+            else fprintf(stderr, "%s: %s\n", argv[2], err.msg);
+            return 1;
+        }
+        report_skips(argv[2], &err);
+    } else if (load_snapshot(argv[2], &list) != 0) {
+        return 1;
+    }
+    int rc = import ? snapshot_write(argv[3], &list) : save_patients_csv(argv[3], &list);
+    if (rc != 0) perror(argv[3]);
+    else printf("%s %zu patients to %s\n", import ? "Imported" : "Exported", list.count, argv[3]);
+    free_patients(&list);
+    return rc == 0 ? 0 : 1;
+}
+
+// hospital_scheduler gen [options] --out file: write a synthetic workload as
+// CSV, or as a snapshot when file ends in .hrs.
+static int gen_main(int argc, char **argv) {
+    WorkloadConfig wcfg;
+    workload_default_config(&wcfg, workload_time_seed());
+    long num_patients = 1000;
+    const char *out_path = NULL;
+    for (int i = 2; i < argc; ++i) {
+        int wrc = 0;
+        if (i+1 < argc && (wrc = workload_parse_option(&wcfg, argv[i], argv[i+1])) != 0) {
+            if (wrc < 0) return 2;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--patients") == 0 && i+1 < argc) num_patients = atol(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) wcfg.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && i+1 < argc) out_path = argv[++i];
+    }
+    if (!out_path || num_patients < 0 || num_patients > INT_MAX) {
+        fprintf(stderr, "Usage: %s gen --patients N --out <file.csv|file.hrs> [--seed S] [--arrivals ...] "
+                        "[--service-time ...] [--clamp MIN,MAX] [--service-mix a,b,c] [--priority-mix a,b,c,d,e] "
+                        "[--threads T]\n", argv[0]);
+        return 2;
+    }
+
+    PatientList list;
+    if (generate_patients(&wcfg, (size_t)num_patients, &list) != 0) {
+        fprintf(stderr, "Cannot generate %ld patients (out of memory or arrivals past 2^32 ms)\n", num_patients);
+        return 1;
+    }
+    int rc = snapshot_is_path(out_path) ? snapshot_write(out_path, &list) : save_patients_csv(out_path, &list);
+    if (rc != 0) perror(out_path);
+    else printf("Generated %zu patients to %s (seed %llu)\n", list.count, out_path, (unsigned long long)wcfg.seed);
+    free_patients(&list);
+    return rc == 0 ? 0 : 1;
+}
+
+// hospital_scheduler sweep [options]: headless grid evaluation, no IPC/logger.
+static int sweep_main(int argc, char **argv) {
+    SweepConfig cfg;
+    sweep_default_config(&cfg);
+    int num_patients = 1000;
+    const char *input_path = NULL;
+    const char *out_path = NULL;
+    int vals[SWEEP_MAX_VALUES];
+    size_t nvals;
+    WorkloadConfig wcfg;
+    workload_default_config(&wcfg, workload_time_seed());
+
+    for (int i = 2; i < argc; ++i) {
+        int bad = 0, wrc = 0;
+        if (i+1 < argc && (wrc = workload_parse_option(&wcfg, argv[i], argv[i+1])) != 0) {
+            if (wrc < 0) return 2;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--patients") == 0 && i+1 < argc) num_patients = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--input") == 0 && i+1 < argc) input_path = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) cfg.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && i+1 < argc) out_path = argv[++i];
+        else if (strcmp(argv[i], "--format") == 0 && i+1 < argc) {
+            ++i;
+            cfg.format = strcmp(argv[i], "json") == 0 ? SWEEP_JSON : SWEEP_CSV;
+        }
+        else if (strcmp(argv[i], "--sort") == 0 && i+1 < argc) {
+            ++i;
+            set_sort_backend(strcmp(argv[i], "qsort") == 0 ? SORT_QSORT : SORT_RADIX);
+        }
+        else if (strcmp(argv[i], "--doctors") == 0 && i+1 < argc) bad = parse_values("--doctors", argv[++i], cfg.doctors, &cfg.num_doctors);
+        else if (strcmp(argv[i], "--machines") == 0 && i+1 < argc) bad = parse_values("--machines", argv[++i], cfg.machines, &cfg.num_machines);
+        else if (strcmp(argv[i], "--rooms") == 0 && i+1 < argc) bad = parse_values("--rooms", argv[++i], cfg.rooms, &cfg.num_rooms);
+        else if (strcmp(argv[i], "--quanta") == 0 && i+1 < argc) {
+            bad = parse_values("--quanta", argv[++i], vals, &nvals);
+            if (!bad) {
+                for (size_t k = 0; k < nvals; ++k) cfg.quanta[k] = (unsigned)vals[k];
+                cfg.num_quanta = nvals;
+            }
+        }
+        else if (strcmp(argv[i], "--algs") == 0 && i+1 < argc) {
+            char buf[256];
+            snprintf(buf, sizeof(buf), "%s", argv[++i]);
+            cfg.num_algs = 0;
+            for (char *tok = strtok(buf, ","); tok && cfg.num_algs < ALG_COUNT; tok = strtok(NULL, ",")) {
+                Algorithm alg;
+                if (lookup_alg(tok, &alg) != 0) {
+                    fprintf(stderr, "sweep: unknown algorithm '%s' "
+                                    "(supported: fcfs,sjf,priority,rr)\n", tok);
+                    return 2;
+                }
+                if (!sweep_supports(alg)) {
+                    fprintf(stderr, "sweep: %s is preemptive and cannot be replayed in the DES "
+                                    "(supported: fcfs,sjf,priority,rr)\n", tok);
+                    return 2;
+                }
+                cfg.algs[cfg.num_algs++] = alg;
+            }
+        }
+        if (bad) return 2;
+    }
+
+    FILE *out = stdout;
+    if (out_path && !(out = fopen(out_path, "w"))) {
+        perror("fopen sweep output");
+        return 1;
+    }
+
+    PatientList list;
+    Snapshot snap;
+    if (load_or_create(input_path, num_patients, &wcfg, &list, &snap) != 0) {
+        if (out != stdout) fclose(out);
+        return 1;
+    }
+    // A snapshot is swept straight from its mapping: orders from the columns, DES rows one at a time
+    PatientSource src = snapshot_source(&snap);
+    int rc = snap.map ? run_sweep_columns(&cfg, &src, &snap.cols, out) : run_sweep(&cfg, &list, out);
+    snapshot_close(&snap);
+    free_patients(&list);
+    if (out != stdout) fclose(out);
+    if (rc != 0) {
+        fprintf(stderr, "Sweep failed\n");
+        return 1;
+    }
+    return 0;
+}
+
+// hospital_scheduler stream [options]: replay an arrival-sorted CSV (or stdin)
+// through the dispatch engine while it is being read.
+static int stream_main(int argc, char **argv) {
+    StreamConfig cfg = { .alg = ALG_FCFS, .out = NULL };
+    const char *input_path = "-";
+    const char *out_path = NULL;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--alg") == 0 && i+1 < argc) cfg.alg = parse_alg(argv[++i]);
+        else if (strcmp(argv[i], "--input") == 0 && i+1 < argc) input_path = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && i+1 < argc) out_path = argv[++i];
+    }
+    if (cfg.alg == ALG_RR) {
+        fprintf(stderr, "stream: Round Robin is only available in batch runs\n");
+        return 2;
+    }
+    if (out_path) {
+        cfg.out = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "w");
+        if (!cfg.out) {
+            perror("fopen stream output");
+            return 1;
+        }
+    }
+
+    StreamResult res;
+    CsvError err;
+    int rc = stream_run(input_path, &cfg, &res, &err);
+    if (cfg.out && cfg.out != stdout) fclose(cfg.out);
+    if (rc != 0) {
+        if (err.line) fprintf(stderr, "%s:%zu: %s\n", input_path, err.line, err.msg);
+        else fprintf(stderr, "%s: %s\n", input_path, err.msg);
+        return 1;
+    }
+    report_skips(input_path, &err);
+    // Keep stdout clean for the rows when they go there
+    FILE *summary = cfg.out == stdout ? stderr : stdout;
+    fprintf(summary, "Algorithm: %s\n", alg_name(cfg.alg));
+    fprintf(summary, "Patients: %zu\n", res.patients);
+    fprintf(summary, "Average Waiting Time: %.2f ms\n", res.avg_wait_ms);
+    fprintf(summary, "Average Turnaround Time: %.2f ms\n", res.avg_turnaround_ms);
+    fprintf(summary, "Makespan: %llu ms\n", res.makespan_ms);
+    fprintf(summary, "Peak In Flight: %zu patients\n", res.peak_in_flight);
+    return 0;
+}
+
+// IPC objects and the logger of one run, released together on every exit path
+typedef struct {
+    LogTransportKind transport;
+    int fifo_fd;
+    int log_shm_fd;
+    ShmLogRing *log_shm;
+    mqd_t mq;
+    int shm_fd;
+    SharedStats *stats;
+    pid_t logger;           // -1 until forked
+} RunIpc;
+
+// Closing the transport ends the logger; a logger that never connected is
+// stopped. Every IPC object is unlinked once it has exited.
+static void run_ipc_teardown(RunIpc *io, int stop_logger) {
+    if (io->fifo_fd != -1) close(io->fifo_fd);
+    if (io->log_shm) shm_log_close(io->log_shm);
+    if (io->mq != (mqd_t)-1) ipc_close_mq(io->mq);
+    if (io->logger > 0 && stop_logger) kill(io->logger, SIGTERM);
+
+    // Allow logger to drain; then cleanup IPC objects
+    if (io->logger > 0) ms_sleep(100);
+    if (io->transport == TRANSPORT_FIFO) ipc_cleanup_fifo();
+    if (io->stats) {
+        munmap(io->stats, sizeof(*io->stats));
+        close(io->shm_fd);
+    }
+    ipc_cleanup_shm();
+
+    // Wait for logger
+    if (io->logger > 0) {
+        int status = 0;
+        waitpid(io->logger, &status, 0);
+    }
+    ipc_cleanup_mq();
+    if (io->log_shm) {
+        // Unlinked only now so a slow-starting logger can still open it
+        ipc_close_log_ring(io->log_shm_fd, io->log_shm);
+        ipc_cleanup_log_ring();
+    }
 }
 
 int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "sweep") == 0) return sweep_main(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "stream") == 0) return stream_main(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "gen") == 0) return gen_main(argc, argv);
+    if (argc > 1 && (strcmp(argv[1], "import") == 0 || strcmp(argv[1], "export") == 0))
+        return convert_main(argc, argv);
+
     // Defaults
     Algorithm alg = ALG_FCFS;
     int num_patients = 10;
     int num_doctors = 3, num_machines = 2, num_rooms = 4;
     unsigned quantum_ms = 3; // for RR
+    RunMode mode = MODE_THREADS;
+    int num_workers = 0; // 0 = size the pool to total resource capacity
+    int pathways = 0;    // 1 = every patient visits consultation, lab and treatment
+    const char *input_path = NULL;  // CSV of patients instead of random ones
+    const char *trace_path = NULL;  // Chrome trace-event JSON output
+    LogTransportKind transport = TRANSPORT_FIFO;
+    DesConfig des_cfg;
+    des_default_config(&des_cfg);
+
+    WorkloadConfig wcfg;
+    workload_default_config(&wcfg, workload_time_seed());
 
     for (int i = 1; i < argc; ++i) {
-        if (strcmp(argv[i], "--alg") == 0 && i+1 < argc) alg = parse_alg(argv[++i]);
+        int wrc = 0;
+        if (i+1 < argc && (wrc = workload_parse_option(&wcfg, argv[i], argv[i+1])) != 0) {
+            if (wrc < 0) return 2;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--alg") == 0 && i+1 < argc) alg = parse_alg(argv[++i]);
         else if (strcmp(argv[i], "--patients") == 0 && i+1 < argc) num_patients = atoi(argv[++i]);
         else if (strcmp(argv[i], "--doctors") == 0 && i+1 < argc) num_doctors = atoi(argv[++i]);
         else if (strcmp(argv[i], "--machines") == 0 && i+1 < argc) num_machines = atoi(argv[++i]);
         else if (strcmp(argv[i], "--rooms") == 0 && i+1 < argc) num_rooms = atoi(argv[++i]);
         else if (strcmp(argv[i], "--quantum") == 0 && i+1 < argc) quantum_ms = (unsigned)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--sort") == 0 && i+1 < argc) {
+            ++i;
+            set_sort_backend(strcmp(argv[i], "qsort") == 0 ? SORT_QSORT : SORT_RADIX);
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i+1 < argc) num_workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pathways") == 0) pathways = 1;
+        else if (strcmp(argv[i], "--input") == 0 && i+1 < argc) input_path = argv[++i];
+        else if (strcmp(argv[i], "--mode") == 0 && i+1 < argc) mode = parse_mode(argv[++i]);
+        else if (strncmp(argv[i], "--mode=", 7) == 0) mode = parse_mode(argv[i] + 7);
+        else if (strcmp(argv[i], "--release") == 0 && i+1 < argc) {
+            ++i;
+            des_cfg.release = strcmp(argv[i], "arrival") == 0 ? DES_RELEASE_ARRIVAL : DES_RELEASE_ORDER;
+        }
+        else if (strcmp(argv[i], "--log-transport") == 0 && i+1 < argc) {
+            ++i;
+            transport = strcmp(argv[i], "shm") == 0 ? TRANSPORT_SHM : TRANSPORT_FIFO;
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i+1 < argc) trace_path = argv[++i];
     }
 
-    // IPC setup
-    if (ipc_setup_fifo() != 0) return 1;
-    mqd_t mq = ipc_open_mq(1);
-    int shm_fd = -1; SharedStats *stats = NULL;
-    if (ipc_setup_shm(&shm_fd, &stats, 1) != 0) {
+    // Patients: loaded before any IPC object exists so a bad file leaves nothing behind
+    PatientList list;
+    Snapshot snap;
+    if (load_or_create(input_path, num_patients, &wcfg, &list, &snap) != 0) return 1;
+    if (pathways) {
+        // The pathway rewrites every patient, so a snapshot needs its rows first
+        if (snap.map && snapshot_rows(input_path, &snap, &list) != 0) return 1;
+        patients_apply_standard_pathway(&list);
+    }
+    size_t num = snap.map ? snap.cols.count : list.count;
+
+    // IPC setup: the log transport must exist before the logger starts
+    RunIpc io = { .transport = transport, .fifo_fd = -1, .log_shm_fd = -1, .log_shm = NULL,
+                  .mq = (mqd_t)-1, .shm_fd = -1, .stats = NULL, .logger = -1 };
+    if (transport == TRANSPORT_SHM) {
+        if (ipc_setup_log_ring(&io.log_shm_fd, &io.log_shm, 1) != 0) {
+            fprintf(stderr, "Failed to setup shared-memory log ring\n");
+            snapshot_close(&snap);
+            free_patients(&list);
+            return 1;
+        }
+    } else if (ipc_setup_fifo() != 0) {
+        snapshot_close(&snap);
+        free_patients(&list);
+        return 1;
+    }
+    io.mq = ipc_open_mq(1);
+    if (ipc_setup_shm(&io.shm_fd, &io.stats, 1) != 0) {
         fprintf(stderr, "Failed to setup shared memory\n");
+        run_ipc_teardown(&io, 0);
+        snapshot_close(&snap);
+        free_patients(&list);
         return 1;
     }
 
+    // Tracing starts before any thread exists; the logger traces into a
+    // fragment that is merged once it exits
+    char trace_fragment[PATH_MAX];
+    if (trace_path) {
+        snprintf(trace_fragment, sizeof(trace_fragment), "%s.logger", trace_path);
+        trace_start("hospital_scheduler");
+        trace_thread_name("main");
+    }
+
     // Fork logger and exec
     pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork logger");
+        run_ipc_teardown(&io, 0);
+        snapshot_close(&snap);
+        free_patients(&list);
+        return 1;
+    }
     if (pid == 0) {
-        execl("bin/logger", "logger", (char *)NULL);
+        const char *transport_arg = transport == TRANSPORT_SHM ? "shm" : "fifo";
+        if (trace_path)
+            execl("bin/logger", "logger", "--transport", transport_arg, "--trace", trace_fragment, (char *)NULL);
+        else
+            execl("bin/logger", "logger", "--transport", transport_arg, (char *)NULL);
         perror("exec logger");
         _exit(127);
     }
 
+    io.logger = pid;
+
     // Parent opens FIFO for writing
-    int fifo_fd = open(FIFO_PATH, O_WRONLY);
-    if (fifo_fd == -1) {
-        perror("open FIFO for write");
-        return 1;
+    if (transport == TRANSPORT_FIFO) {
+        io.fifo_fd = open(FIFO_PATH, O_WRONLY);
+        if (io.fifo_fd == -1) {
+            perror("open FIFO for write");
+            run_ipc_teardown(&io, 1);
+            snapshot_close(&snap);
+            free_patients(&list);
+            return 1;
+        }
     }
 
     // Resources
     ResourcePool resources;
     if (resources_init(&resources, num_doctors, num_machines, num_rooms) != 0) {
         fprintf(stderr, "Failed to init resources\n");
+        run_ipc_teardown(&io, 0);
+        snapshot_close(&snap);
+        free_patients(&list);
         return 1;
     }
 
-    // Patients
-    PatientList list = create_patients((size_t)num_patients);
-
-    // Scheduling
-    int *order = schedule_order(&list, alg, quantum_ms);
-    ScheduleMetrics metrics = compute_metrics(&list, order, alg, quantum_ms);
+    // Batched binary logging: one flusher thread owns the FIFO
+    LogRing log_ring;
+    LogClock log_clock = mode == MODE_DES ? LOG_CLOCK_VIRTUAL : LOG_CLOCK_MONOTONIC;
+    LogTransport log_out = { .fd = io.fifo_fd, .shm = io.log_shm };
+    if (log_ring_init(&log_ring, &log_out, LOG_RING_DEFAULT_CAP, log_clock) != 0) {
+        fprintf(stderr, "Failed to start log flusher\n");
+        resources_destroy(&resources);
+        run_ipc_teardown(&io, 0);
+        snapshot_close(&snap);
+        free_patients(&list);
+        return 1;
+    }
 
-    // Write stats to shared memory and notify logger via MQ
-    stats->avg_wait_ms = metrics.avg_wait_ms;
-    stats->avg_turnaround_ms = metrics.avg_turnaround_ms;
-    stats->completed_jobs = (int)list.count;
-    mq_send(mq, "STATS_READY", strlen("STATS_READY"), 1);
+    // Scheduling: straight from a snapshot's mapped columns, else gathered from the rows
+    uint64_t t_trace = trace_begin();
+    int *order;
+    ScheduleMetrics metrics;
+    if (snap.map) {
+        order = schedule_order_columns(&snap.cols, alg, quantum_ms);
+        metrics = compute_metrics_columns(&snap.cols, order, alg, quantum_ms);
+    } else {
+        order = schedule_order(&list, alg, quantum_ms);
+        metrics = compute_metrics(&list, order, alg, quantum_ms);
+    }
+    trace_end("schedule", t_trace, "patients", (int64_t)num);
 
-    // Launch threads in scheduled order
-    pthread_t *threads = (pthread_t *)calloc(list.count, sizeof(pthread_t));
-    WorkerArgs *args = (WorkerArgs *)calloc(list.count, sizeof(WorkerArgs));
-    for (size_t k = 0; k < list.count; ++k) {
-        int idx = order[k]; 
-        args[k].patient = list.items[idx];
-        args[k].resources = &resources;
-        args[k].fifo_fd = fifo_fd;
-        pthread_create(&threads[k], NULL, patient_thread, &args[k]);
-        // Space out starts slightly to reflect scheduling order
-        ms_sleep(10);
+    // Live stats page: published continuously while patients are served
+    LiveStats live;
+    if (live_stats_init(&live, io.stats, &metrics, (int)num, LIVE_STATS_PERIOD_MS) != 0) {
+        fprintf(stderr, "Failed to start stats publisher\n");
+        log_ring_destroy(&log_ring);
+        free(order);
+        resources_destroy(&resources);
+        run_ipc_teardown(&io, 0);
+        snapshot_close(&snap);
+        free_patients(&list);
+        return 1;
     }
+    resources.live = &live;
 
-    for (size_t k = 0; k < list.count; ++k) 
-    {
-        pthread_join(threads[k], NULL);
+    size_t completed = num;
+    DesResult des_res = {0};
+    if (mode == MODE_DES) {
+        // Replay on a virtual clock; no threads, no sleeping. A snapshot is
+        // read from its mapping one row at a time.
+        PatientSource src = snap.map ? snapshot_source(&snap) : patient_list_source(&list);
+        if (des_run(&src, order, &resources, &des_cfg, &log_ring, &des_res) != 0) {
+            fprintf(stderr, "DES run failed\n");
+            completed = 0;
+        }
+    } else if (snap.map && snapshot_rows(input_path, &snap, &list) != 0) {
+        completed = 0;
+    } else {
+        // Serve patients in scheduled order on a bounded worker pool
+        if (run_worker_pool(&list, order, &resources, &log_ring, num_workers) != 0) {
+            fprintf(stderr, "Failed to start worker threads\n");
+            completed = 0;
+        }
     }
+    snapshot_close(&snap);
+
+    // Final snapshot, then notify logger via MQ while its transport is still open
+    live_stats_destroy(&live);
+    resources.live = NULL;
+    mq_send(io.mq, "STATS_READY", strlen("STATS_READY"), 1);
 
-    // Cleanup
+    // Cleanup: flush every queued record before the FIFO closes
+    log_ring_destroy(&log_ring);
     free(order);
-    free(threads);
-    free(args);
     free_patients(&list);
 
+    ResourceTotals totals[RESOURCE_TYPE_COUNT];
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r) resources_totals(&resources, (ResourceType)r, &totals[r]);
     resources_destroy(&resources);
 
-    close(fifo_fd);
-    ipc_close_mq(mq);
-
-    // Allow logger to drain; then cleanup IPC objects
-    ms_sleep(100);
-    ipc_cleanup_fifo();
-    munmap(stats, sizeof(*stats));
-    close(shm_fd);
-    ipc_cleanup_shm();
-
-    // Wait for logger
-    int status = 0; waitpid(pid, &status, 0);
+    run_ipc_teardown(&io, 0);
+    int trace_written = 0;
+    if (trace_path) {
+        trace_written = trace_write_json(trace_path, trace_fragment) == 0;
+        unlink(trace_fragment);
+        trace_reset();
+    }
 
+    static const char *type_labels[RESOURCE_TYPE_COUNT] = { "Doctor", "Machine", "Room" };
     printf("Algorithm: %s\n", alg_name(alg));
+    if (!input_path) printf("Seed: %llu\n", (unsigned long long)wcfg.seed);
     printf("Average Waiting Time: %.2f ms\n", metrics.avg_wait_ms);
     printf("Average Turnaround Time: %.2f ms\n", metrics.avg_turnaround_ms);
-    printf("Completed Jobs: %d\n", (int)list.count);
+    print_latency("Wait", &metrics.wait);
+    print_latency("Turnaround", &metrics.turnaround);
+    for (int c = 0; c < METRICS_PRIORITY_CLASSES; ++c) {
+        char label[32];
+        snprintf(label, sizeof(label), "  Priority %d Wait", c + 1);
+        print_latency(label, &metrics.wait_by_priority[c]);
+    }
+    for (int sv = 0; sv < SERVICE_TYPE_COUNT; ++sv) {
+        char label[32];
+        snprintf(label, sizeof(label), "  %s Wait", log_service_name((unsigned)sv));
+        print_latency(label, &metrics.wait_by_service[sv]);
+    }
+    printf("Completed Jobs: %d\n", (int)completed);
+    if (mode == MODE_DES) {
+        unsigned long long span = des_res.makespan_ms;
+        printf("Simulated Makespan: %llu ms\n", span);
+        printf("Simulated Avg Wait (with contention): %.2f ms\n", des_res.observed.avg_wait_ms);
+        printf("Simulated Avg Turnaround (with contention): %.2f ms\n", des_res.observed.avg_turnaround_ms);
+        for (int r = 0; r < RESOURCE_TYPE_COUNT && span > 0; ++r)
+            printf("%s Utilization: %.1f%%\n", type_labels[r],
+                   100.0 * totals[r].busy_ms / (span * (unsigned long long)totals[r].units));
+        const DesCriticalPath *cp = &des_res.critical;
+        if (cp->k >= 0) {
+            printf("Critical Path: patient %d released at %llu ms", cp->patient_id, cp->release_ms);
+            for (int s = 0; s < cp->steps; ++s)
+                printf(" > %s (queued %llu + served %u ms)", log_service_name(cp->path[s].service),
+                       cp->wait_ms[s], cp->path[s].duration_ms);
+            printf(" = %llu ms\n", span);
+        }
+    }
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r) {
+        const ResourceTotals *t = &totals[r];
+        printf("%s Wait: %.2f ms avg, peak %d/%d in use\n", type_labels[r],
+               t->served ? (double)t->wait_ms / t->served : 0.0, t->max_in_use, t->units);
+    }
+    if (trace_written) printf("Trace: %s\n", trace_path);
 
     return 0;
 }
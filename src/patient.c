@@ -1,32 +1,15 @@
 #include "patient.h"
-
-static ServiceType rand_service() {
-    int r = rand() % 3;
-    switch (r) {
-        case 0: return SERVICE_CONSULTATION;
-        case 1: return SERVICE_LAB_TEST;
-        default: return SERVICE_TREATMENT;
-    }
-}
+#include "workload.h"
+#include <limits.h>
 
 PatientList create_patients(size_t n) {
-    PatientList list = {0};
-    list.count = n;
-    list.items = (Patient *)calloc(n, sizeof(Patient));
-    if (!list.items) {
+    WorkloadConfig cfg;
+    workload_default_config(&cfg, workload_time_seed());
+    PatientList list;
+    if (generate_patients(&cfg, n, &list) != 0) {
         fprintf(stderr, "Allocation failed for patients\n");
         exit(1);
     }
-    srand((unsigned)time(NULL));
-    for (size_t i = 0; i < n; ++i) {
-        Patient *p = &list.items[i];
-        p->id = (int)i + 1;
-        snprintf(p->name, MAX_NAME_LEN, "Patient_%02d", p->id);
-        p->priority = (rand() % 5) + 1; // 1..5
-        p->service = rand_service();
-        p->required_time_ms = (unsigned)(100 + (rand() % 900)); // 100..1000 ms
-        p->arrival_ms = (unsigned)(rand() % 500); // 0..500 ms
-    }
     return list;
 }
 
@@ -36,3 +19,96 @@ void free_patients(PatientList *list) {
     list->items = NULL;
     list->count = 0;
 }
+
+PatientSource patient_list_source(const PatientList *list) {
+    return (PatientSource){ .count = list->count, .rows = list->items, .ctx = NULL, .read = NULL };
+}
+
+int patient_set_path(Patient *p, const PathStep *steps, int n) {
+    if (n < 1 || n > MAX_PATH_STEPS) return -1;
+    uint64_t total = 0;
+    for (int s = 0; s < n; ++s) total += steps[s].duration_ms;
+    if (total > UINT_MAX) return -1;
+    for (int s = 0; s < n; ++s) p->path[s] = steps[s];
+    p->path_len = (unsigned char)n;
+    p->service = (ServiceType)steps[0].service;
+    p->required_time_ms = (unsigned)total;
+    return 0;
+}
+
+void patients_apply_standard_pathway(PatientList *list) {
+    for (size_t i = 0; i < list->count; ++i) {
+        Patient *p = &list->items[i];
+        unsigned total = p->required_time_ms;
+        unsigned consult = (unsigned)((uint64_t)total * 3 / 10);
+        unsigned lab = (unsigned)((uint64_t)total * 4 / 10);
+        PathStep steps[3] = {
+            { SERVICE_CONSULTATION, 0, consult },
+            { SERVICE_LAB_TEST, 0, lab },
+            { SERVICE_TREATMENT, 0, total - consult - lab }
+        };
+        patient_set_path(p, steps, 3);
+    }
+}
+
+int patient_columns_build(const PatientList *list, PatientColumns *cols, int flags) {
+    memset(cols, 0, sizeof(*cols));
+    size_t n = list->count;
+    size_t slots = n ? n : 1;
+    cols->count = n;
+    cols->arrival_ms = (unsigned *)malloc(sizeof(unsigned) * slots);
+    cols->burst_ms = (unsigned *)malloc(sizeof(unsigned) * slots);
+    cols->priority = (int *)malloc(sizeof(int) * slots);
+    cols->service = (unsigned char *)malloc(slots);
+    if (!cols->arrival_ms || !cols->burst_ms || !cols->priority || !cols->service) {
+        patient_columns_free(cols);
+        return -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const Patient *p = &list->items[i];
+        cols->arrival_ms[i] = p->arrival_ms;
+        cols->burst_ms[i] = p->required_time_ms;
+        cols->priority[i] = p->priority;
+        cols->service[i] = (unsigned char)p->service;
+    }
+    if (!(flags & PATIENT_COLS_NAMES)) return 0;
+
+    // String table: every name NUL-terminated back to back
+    size_t bytes = 0;
+    for (size_t i = 0; i < n; ++i) bytes += strnlen(list->items[i].name, MAX_NAME_LEN - 1) + 1;
+    cols->id = (int *)malloc(sizeof(int) * slots);
+    cols->name_off = (uint32_t *)malloc(sizeof(uint32_t) * slots);
+    cols->names = (char *)malloc(bytes ? bytes : 1);
+    if (!cols->id || !cols->name_off || !cols->names || bytes > UINT32_MAX) {
+        patient_columns_free(cols);
+        return -1;
+    }
+    size_t off = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const Patient *p = &list->items[i];
+        size_t len = strnlen(p->name, MAX_NAME_LEN - 1);
+        cols->id[i] = p->id;
+        cols->name_off[i] = (uint32_t)off;
+        memcpy(cols->names + off, p->name, len);
+        cols->names[off + len] = '\0';
+        off += len + 1;
+    }
+    return 0;
+}
+
+void patient_columns_free(PatientColumns *cols) {
+    if (!cols) return;
+    free(cols->arrival_ms);
+    free(cols->burst_ms);
+    free(cols->priority);
+    free(cols->service);
+    free(cols->id);
+    free(cols->name_off);
+    free(cols->names);
+    memset(cols, 0, sizeof(*cols));
+}
+
+const char *patient_columns_name(const PatientColumns *cols, size_t i) {
+    if (!cols->names || i >= cols->count) return "";
+    return cols->names + cols->name_off[i];
+}
@@ -1,32 +1,290 @@
+#include "common.h"
 #include "resources.h"
+#include "trace.h"
 #include <stdio.h>
 
+struct ResourceWaiter {
+    uint64_t rank;
+    uint64_t arrival;
+    ResourceMask mask;
+    int skipped;                // later-ranked grants made while this one waited
+    int granted;                // set by the granting thread
+    ResourceGrant *grant;
+    pthread_cond_t cond;
+};
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static int account_init(ResourceAccount *a, int count) {
+    memset(a, 0, sizeof(*a));
+    a->units = (UnitCounter *)aligned_alloc(64, sizeof(UnitCounter) * (size_t)count);
+    a->free_units = (int *)malloc(sizeof(int) * (size_t)count);
+    if (!a->units || !a->free_units) {
+        free(a->units); free(a->free_units);
+        a->units = NULL; a->free_units = NULL;
+        return -1;
+    }
+    // Stack top is unit 0, so an idle pool hands out the lowest ids first
+    for (int u = 0; u < count; ++u) {
+        a->free_units[u] = count - 1 - u;
+        atomic_init(&a->units[u].busy_ms, 0);
+        atomic_init(&a->units[u].served, 0);
+        a->units[u].timeline = (UnitTimeline){0};
+    }
+    a->free_count = count;
+    atomic_init(&a->busy_ms, 0);
+    atomic_init(&a->wait_ms, 0);
+    atomic_init(&a->served, 0);
+    atomic_init(&a->in_use, 0);
+    atomic_init(&a->max_in_use, 0);
+    a->count = count;
+    return 0;
+}
+
+static void account_destroy(ResourceAccount *a) {
+    if (!a->units) return;
+    for (int u = 0; u < a->count; ++u) free(a->units[u].timeline.items);
+    free(a->units);
+    free(a->free_units);
+    a->units = NULL;
+    a->free_units = NULL;
+}
+
 int resources_init(ResourcePool *rp, int num_doctors, int num_machines, int num_rooms) {
-    if (sem_init(&rp->doctors, 0, (unsigned int)(num_doctors > 0 ? num_doctors : 1)) != 0) return -1;
-    if (sem_init(&rp->machines, 0, (unsigned int)(num_machines > 0 ? num_machines : 1)) != 0) return -1;
-    if (sem_init(&rp->rooms, 0, (unsigned int)(num_rooms > 0 ? num_rooms : 1)) != 0) return -1;
-    if (pthread_mutex_init(&rp->log_mutex, NULL) != 0) return -1;
     rp->num_doctors = (num_doctors > 0 ? num_doctors : 1);
     rp->num_machines = (num_machines > 0 ? num_machines : 1);
     rp->num_rooms = (num_rooms > 0 ? num_rooms : 1);
-    rp->busy_doctors_ms = 0ULL;
-    rp->busy_machines_ms = 0ULL;
-    rp->busy_rooms_ms = 0ULL;
+    int counts[RESOURCE_TYPE_COUNT] = { rp->num_doctors, rp->num_machines, rp->num_rooms };
+    if (pthread_mutex_init(&rp->lock, NULL) != 0) return -1;
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) {
+        if (account_init(&rp->acct[t], counts[t]) != 0) {
+            while (--t >= 0) account_destroy(&rp->acct[t]);
+            pthread_mutex_destroy(&rp->lock);
+            return -1;
+        }
+    }
+    rp->ready = NULL;
+    rp->ready_count = rp->ready_cap = 0;
+    rp->arrivals = 0;
+    rp->record_timeline = 0;
+    rp->epoch_ms = now_ms();
+    rp->live = NULL;
     return 0;
 }
 
 void resources_destroy(ResourcePool *rp) {
-    sem_destroy(&rp->doctors);
-    sem_destroy(&rp->machines);
-    sem_destroy(&rp->rooms);
-    pthread_mutex_destroy(&rp->log_mutex);
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) account_destroy(&rp->acct[t]);
+    free(rp->ready);
+    rp->ready = NULL;
+    pthread_mutex_destroy(&rp->lock);
+}
+
+void resources_enable_timeline(ResourcePool *rp) {
+    rp->record_timeline = 1;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Ready queue (caller holds the pool lock)
+// ─────────────────────────────────────────────────────────────────────────────
+static int waiter_before(const struct ResourceWaiter *a, const struct ResourceWaiter *b) {
+    if (a->rank != b->rank) return a->rank < b->rank;
+    return a->arrival < b->arrival;
+}
+
+// Sorted insert: the queue only holds blocked callers (at most one per
+// worker), so a linear shift is cheaper than keeping a heap walkable in order.
+static int ready_insert(ResourcePool *rp, struct ResourceWaiter *w) {
+    if (rp->ready_count == rp->ready_cap) {
+        size_t ncap = rp->ready_cap ? rp->ready_cap * 2 : 64;
+        struct ResourceWaiter **nr = (struct ResourceWaiter **)realloc(rp->ready, sizeof(*nr) * ncap);
+        if (!nr) return -1;
+        rp->ready = nr;
+        rp->ready_cap = ncap;
+    }
+    size_t i = rp->ready_count++;
+    while (i > 0 && waiter_before(w, rp->ready[i - 1])) {
+        rp->ready[i] = rp->ready[i - 1];
+        --i;
+    }
+    rp->ready[i] = w;
+    return 0;
+}
+
+static void atomic_max_int(_Atomic int *dst, int v) {
+    int cur = atomic_load_explicit(dst, memory_order_relaxed);
+    while (v > cur && !atomic_compare_exchange_weak_explicit(dst, &cur, v, memory_order_relaxed,
+                                                             memory_order_relaxed)) {}
+}
+
+static int fits(const ResourcePool *rp, ResourceMask mask) {
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t)
+        if ((mask & RESOURCE_MASK(t)) && rp->acct[t].free_count == 0) return 0;
+    return 1;
 }
 
-sem_t *resource_for_service(ResourcePool *rp, ServiceType service) {
-    switch (service) {
-        case SERVICE_CONSULTATION: return &rp->doctors;
-        case SERVICE_LAB_TEST: return &rp->machines;
-        case SERVICE_TREATMENT: return &rp->rooms;
-        default: return &rp->rooms;
+static void take_units(ResourcePool *rp, ResourceMask mask, ResourceGrant *grant) {
+    grant->mask = mask;
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) {
+        ResourceAccount *a = &rp->acct[t];
+        if (!(mask & RESOURCE_MASK(t))) { grant->unit[t] = -1; continue; }
+        grant->unit[t] = a->free_units[--a->free_count];
+        int held = atomic_fetch_add_explicit(&a->in_use, 1, memory_order_relaxed) + 1;
+        atomic_max_int(&a->max_in_use, held);
     }
 }
+
+// Walk the ready queue in rank order and grant every waiter whose units are
+// all free. Waiters that do not fit are backfilled around, except that an
+// aged waiter reserves one unit of each type it needs against everyone
+// behind it; the remaining units of those types stay grantable.
+static void dispatch(ResourcePool *rp) {
+    int avail[RESOURCE_TYPE_COUNT];   // free units not reserved by aged waiters ahead (may go negative)
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) avail[t] = rp->acct[t].free_count;
+    size_t keep = 0;
+    for (size_t i = 0; i < rp->ready_count; ++i) {
+        struct ResourceWaiter *w = rp->ready[i];
+        int ok = 1;
+        for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t)
+            if ((w->mask & RESOURCE_MASK(t)) && avail[t] <= 0) ok = 0;
+        if (ok || w->skipped >= RESOURCE_AGING_LIMIT) {
+            for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t)
+                if (w->mask & RESOURCE_MASK(t)) avail[t]--;
+        }
+        if (ok) {
+            take_units(rp, w->mask, w->grant);
+            w->granted = 1;
+            pthread_cond_signal(&w->cond);
+            // Everyone still queued ahead of w was overtaken
+            for (size_t j = 0; j < keep; ++j) rp->ready[j]->skipped++;
+            continue;
+        }
+        rp->ready[keep++] = w;
+    }
+    rp->ready_count = keep;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Acquire / release
+// ─────────────────────────────────────────────────────────────────────────────
+static void timeline_append(UnitTimeline *tl, int patient_id, uint64_t start_ms, uint64_t end_ms) {
+    if (tl->count == tl->cap) {
+        size_t ncap = tl->cap ? tl->cap * 2 : 16;
+        UnitInterval *ni = (UnitInterval *)realloc(tl->items, sizeof(UnitInterval) * ncap);
+        if (!ni) return;   // timeline is best-effort; counters stay exact
+        tl->items = ni;
+        tl->cap = ncap;
+    }
+    tl->items[tl->count++] = (UnitInterval){ patient_id, start_ms, end_ms };
+}
+
+int resources_acquire_set(ResourcePool *rp, ResourceMask mask, uint64_t rank, ResourceGrant *grant) {
+    mask &= RESOURCE_MASK(RESOURCE_TYPE_COUNT) - 1;
+    if (mask == 0) return -1;
+    uint64_t t0 = now_ms();
+
+    pthread_mutex_lock(&rp->lock);
+    if (rp->ready_count == 0 && fits(rp, mask)) {
+        take_units(rp, mask, grant);
+    } else {
+        struct ResourceWaiter w = { .rank = rank, .arrival = rp->arrivals++, .mask = mask, .grant = grant };
+        pthread_cond_init(&w.cond, NULL);
+        if (ready_insert(rp, &w) != 0) {
+            pthread_mutex_unlock(&rp->lock);
+            pthread_cond_destroy(&w.cond);
+            return -1;
+        }
+        // Units may be free but reserved for others queued ahead; let the walk decide
+        dispatch(rp);
+        uint64_t t_trace = trace_begin();
+        while (!w.granted) pthread_cond_wait(&w.cond, &rp->lock);
+        trace_end("blocked", t_trace, "rank", (int64_t)rank);
+        pthread_cond_destroy(&w.cond);
+    }
+    pthread_mutex_unlock(&rp->lock);
+
+    uint64_t t1 = now_ms();
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t)
+        if (mask & RESOURCE_MASK(t))
+            atomic_fetch_add_explicit(&rp->acct[t].wait_ms, t1 - t0, memory_order_relaxed);
+    grant->waited_ms = t1 - t0;
+    grant->start_ms = t1 - rp->epoch_ms;
+    return 0;
+}
+
+int resources_acquire(ResourcePool *rp, ResourceType t, uint64_t rank, ResourceGrant *grant) {
+    return resources_acquire_set(rp, RESOURCE_MASK(t), rank, grant);
+}
+
+void resources_release(ResourcePool *rp, const ResourceGrant *grant, int patient_id, uint64_t busy_ms) {
+    uint64_t t_trace = trace_begin();
+    uint64_t end = now_ms() - rp->epoch_ms;
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) {
+        if (!(grant->mask & RESOURCE_MASK(t))) continue;
+        ResourceAccount *a = &rp->acct[t];
+        UnitCounter *uc = &a->units[grant->unit[t]];
+        atomic_fetch_add_explicit(&uc->busy_ms, busy_ms, memory_order_relaxed);
+        atomic_fetch_add_explicit(&uc->served, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&a->busy_ms, busy_ms, memory_order_relaxed);
+        atomic_fetch_add_explicit(&a->served, 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&a->in_use, 1, memory_order_relaxed);
+    }
+
+    pthread_mutex_lock(&rp->lock);
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) {
+        if (!(grant->mask & RESOURCE_MASK(t))) continue;
+        ResourceAccount *a = &rp->acct[t];
+        if (rp->record_timeline) timeline_append(&a->units[grant->unit[t]].timeline, patient_id, grant->start_ms, end);
+        a->free_units[a->free_count++] = grant->unit[t];
+    }
+    dispatch(rp);
+    pthread_mutex_unlock(&rp->lock);
+    trace_end("release", t_trace, "patient", patient_id);
+}
+
+void resources_record_slice(ResourcePool *rp, ResourceType t, int unit, int patient_id,
+                            uint64_t start_ms, uint64_t end_ms) {
+    UnitCounter *uc = &rp->acct[t].units[unit];
+    atomic_fetch_add_explicit(&uc->busy_ms, end_ms - start_ms, memory_order_relaxed);
+    atomic_fetch_add_explicit(&uc->served, 1, memory_order_relaxed);
+    if (rp->record_timeline) timeline_append(&uc->timeline, patient_id, start_ms, end_ms);
+}
+
+void resources_merge_totals(ResourcePool *rp, ResourceType t, const ResourceTotals *add) {
+    ResourceAccount *a = &rp->acct[t];
+    atomic_fetch_add_explicit(&a->busy_ms, add->busy_ms, memory_order_relaxed);
+    atomic_fetch_add_explicit(&a->wait_ms, add->wait_ms, memory_order_relaxed);
+    atomic_fetch_add_explicit(&a->served, add->served, memory_order_relaxed);
+    atomic_max_int(&a->max_in_use, add->max_in_use);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Readers
+// ─────────────────────────────────────────────────────────────────────────────
+void resources_totals(const ResourcePool *rp, ResourceType t, ResourceTotals *out) {
+    ResourceAccount *a = (ResourceAccount *)&rp->acct[t];
+    out->units = a->count;
+    out->busy_ms = atomic_load_explicit(&a->busy_ms, memory_order_relaxed);
+    out->wait_ms = atomic_load_explicit(&a->wait_ms, memory_order_relaxed);
+    out->served = atomic_load_explicit(&a->served, memory_order_relaxed);
+    out->max_in_use = atomic_load_explicit(&a->max_in_use, memory_order_relaxed);
+}
+
+int resources_units(const ResourcePool *rp, ResourceType t) {
+    return rp->acct[t].count;
+}
+
+uint64_t resources_unit_busy_ms(const ResourcePool *rp, ResourceType t, int unit) {
+    const ResourceAccount *a = &rp->acct[t];
+    if (unit < 0 || unit >= a->count) return 0;
+    return atomic_load_explicit(&a->units[unit].busy_ms, memory_order_relaxed);
+}
+
+const UnitTimeline *resources_unit_timeline(const ResourcePool *rp, ResourceType t, int unit) {
+    const ResourceAccount *a = &rp->acct[t];
+    if (unit < 0 || unit >= a->count) return NULL;
+    return &a->units[unit].timeline;
+}
@@ -0,0 +1,437 @@
+#include "common.h"
+#include "schedcache.h"
+#include "dispatch.h"
+
+#include <pthread.h>
+
+typedef enum { EDIT_ADD, EDIT_CHANGE, EDIT_REMOVE } EditKind;
+
+// Algorithms whose cached schedule is patched instead of recomputed
+static int is_incremental(Algorithm alg) {
+    return alg == ALG_FCFS || alg == ALG_SJF || alg == ALG_PRIORITY;
+}
+
+static void drop_entry(ScheduleCacheEntry *e) {
+    free(e->order);
+    free(e->start);
+    e->order = NULL;
+    e->start = NULL;
+    e->valid = 0;
+    e->version++;
+}
+
+void schedule_cache_init(ScheduleCache *c, unsigned quantum_ms) {
+    memset(c, 0, sizeof(*c));
+    c->quantum_ms = quantum_ms;
+}
+
+void schedule_cache_invalidate(ScheduleCache *c) {
+    for (int a = 0; a < ALG_COUNT; ++a) drop_entry(&c->entries[a]);
+    c->arrival_valid = 0;
+}
+
+void schedule_cache_free(ScheduleCache *c) {
+    schedule_cache_invalidate(c);
+    free(c->by_arrival);
+    free(c->in_prefix);
+    c->by_arrival = NULL;
+    c->in_prefix = NULL;
+    c->count = c->cap = 0;
+}
+
+void schedule_cache_set_quantum(ScheduleCache *c, unsigned quantum_ms) {
+    if (quantum_ms == c->quantum_ms) return;
+    c->quantum_ms = quantum_ms;
+    drop_entry(&c->entries[ALG_RR]);
+}
+
+uint64_t schedule_cache_version(const ScheduleCache *c, Algorithm alg) {
+    return c->entries[alg].version;
+}
+
+// Grow every per-patient array to hold n patients
+static int ensure_cap(ScheduleCache *c, size_t n) {
+    if (n <= c->cap && c->by_arrival) return 0;
+    size_t ncap = c->cap ? c->cap : 16;
+    while (ncap < n) ncap *= 2;
+    int *by_arrival = (int *)realloc(c->by_arrival, sizeof(int) * ncap);
+    if (by_arrival) c->by_arrival = by_arrival;
+    unsigned char *in_prefix = (unsigned char *)realloc(c->in_prefix, ncap);
+    if (in_prefix) c->in_prefix = in_prefix;
+    if (!by_arrival || !in_prefix) return -1;
+    for (int a = 0; a < ALG_COUNT; ++a) {
+        ScheduleCacheEntry *e = &c->entries[a];
+        if (!e->valid) continue;
+        int *order = (int *)realloc(e->order, sizeof(int) * ncap);
+        if (order) e->order = order;
+        unsigned long long *start = e->start ? (unsigned long long *)realloc(e->start, sizeof(unsigned long long) * ncap) : NULL;
+        if (start) e->start = start;
+        if (!order || (e->start && !start)) drop_entry(e);
+    }
+    c->cap = ncap;
+    return 0;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Full computation
+// ─────────────────────────────────────────────────────────────────────────────
+static void summarize(ScheduleCacheEntry *e, size_t n) {
+    if (n == 0) {
+        memset(&e->metrics, 0, sizeof(e->metrics));
+        return;
+    }
+    e->metrics.avg_wait_ms = (double)e->total_wait_ms / n;
+    e->metrics.avg_turnaround_ms = (double)e->total_turnaround_ms / n;
+    metrics_summarize(&e->hist, &e->metrics);
+}
+
+// Only touches c->entries[alg], so one thread per algorithm may run this.
+static int compute_entry(ScheduleCache *c, const PatientColumns *cols, Algorithm alg) {
+    ScheduleCacheEntry *e = &c->entries[alg];
+    size_t n = cols->count;
+    int *order = schedule_order_columns(cols, alg, c->quantum_ms);
+    if (!order) return -1;
+    if (c->cap > n) {
+        int *grown = (int *)realloc(order, sizeof(int) * c->cap);
+        if (!grown) { free(order); return -1; }
+        order = grown;
+    }
+    free(e->order);
+    e->order = order;
+    e->metrics = compute_metrics_hist(cols, order, alg, c->quantum_ms, &e->hist);
+
+    if (is_incremental(alg)) {
+        unsigned long long *start = (unsigned long long *)realloc(e->start, sizeof(unsigned long long) * (c->cap ? c->cap : 1));
+        if (!start) return -1;
+        e->start = start;
+        // Same walk as compute_metrics_hist, keeping each start time
+        unsigned long long time = 0;
+        e->total_wait_ms = e->total_turnaround_ms = 0;
+        for (size_t k = 0; k < n; ++k) {
+            int i = order[k];
+            if (cols->arrival_ms[i] > time) time = cols->arrival_ms[i];
+            start[k] = time;
+            e->total_wait_ms += time - cols->arrival_ms[i];
+            time += cols->burst_ms[i];
+            e->total_turnaround_ms += time - cols->arrival_ms[i];
+        }
+    }
+    e->valid = 1;
+    return 0;
+}
+
+static int build_arrival(ScheduleCache *c, const PatientList *list) {
+    size_t n = list->count;
+    unsigned *keys = (unsigned *)malloc(sizeof(unsigned) * (n ? n : 1));
+    if (!keys) return -1;
+    for (size_t i = 0; i < n; ++i) keys[i] = list->items[i].arrival_ms;
+    int rc = sort_indices_by_key(keys, n, c->by_arrival);
+    free(keys);
+    c->arrival_valid = rc == 0;
+    return rc;
+}
+
+// A list of a different length than the cache describes was not reported
+// edit by edit, so nothing cached can be trusted.
+static void sync_count(ScheduleCache *c, const PatientList *list) {
+    if (c->count == list->count) return;
+    schedule_cache_invalidate(c);
+    c->count = list->count;
+}
+
+static ScheduleCacheEntry *lookup(ScheduleCache *c, const PatientList *list, Algorithm alg) {
+    sync_count(c, list);
+    ScheduleCacheEntry *e = &c->entries[alg];
+    if (e->valid) return e;
+    if (ensure_cap(c, list->count) != 0) return NULL;
+    PatientColumns cols;
+    if (patient_columns_build(list, &cols, 0) != 0) return NULL;
+    int rc = compute_entry(c, &cols, alg);
+    patient_columns_free(&cols);
+    return rc == 0 ? e : NULL;
+}
+
+const int *schedule_cache_order(ScheduleCache *c, const PatientList *list, Algorithm alg) {
+    ScheduleCacheEntry *e = lookup(c, list, alg);
+    return e ? e->order : NULL;
+}
+
+const ScheduleMetrics *schedule_cache_metrics(ScheduleCache *c, const PatientList *list, Algorithm alg) {
+    ScheduleCacheEntry *e = lookup(c, list, alg);
+    return e ? &e->metrics : NULL;
+}
+
+const unsigned long long *schedule_cache_starts(ScheduleCache *c, const PatientList *list, Algorithm alg) {
+    if (!is_incremental(alg)) return NULL;
+    ScheduleCacheEntry *e = lookup(c, list, alg);
+    return e ? e->start : NULL;
+}
+
+typedef struct {
+    ScheduleCache *cache;
+    const PatientColumns *cols;
+    Algorithm alg;
+} RefreshJob;
+
+static void *refresh_job(void *arg) {
+    RefreshJob *job = (RefreshJob *)arg;
+    compute_entry(job->cache, job->cols, job->alg);
+    return NULL;
+}
+
+void schedule_cache_refresh_all(ScheduleCache *c, const PatientList *list) {
+    sync_count(c, list);
+    if (ensure_cap(c, list->count) != 0) return;
+    PatientColumns cols;   // gathered once, shared read-only by every job
+    if (patient_columns_build(list, &cols, 0) != 0) return;
+
+    RefreshJob jobs[ALG_COUNT];
+    pthread_t threads[ALG_COUNT];
+    int started[ALG_COUNT] = {0};
+    for (int a = 0; a < ALG_COUNT; ++a) {
+        if (c->entries[a].valid) continue;
+        jobs[a] = (RefreshJob){ .cache = c, .cols = &cols, .alg = (Algorithm)a };
+        started[a] = pthread_create(&threads[a], NULL, refresh_job, &jobs[a]) == 0;
+        if (!started[a]) refresh_job(&jobs[a]);   // fall back to running inline
+    }
+    for (int a = 0; a < ALG_COUNT; ++a)
+        if (started[a]) pthread_join(threads[a], NULL);
+    patient_columns_free(&cols);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Edits
+// ─────────────────────────────────────────────────────────────────────────────
+// The patient that had index i before the edit
+static const Patient *old_patient(const PatientList *list, EditKind kind, size_t idx,
+                                  const Patient *before, size_t i) {
+    if (kind != EDIT_ADD && i == idx) return before;
+    if (kind == EDIT_REMOVE && i > idx) return &list->items[i - 1];
+    return &list->items[i];
+}
+
+// (arrival_ms, index) order of by_arrival
+static int arrives_before(const PatientList *list, int a, int b) {
+    unsigned ta = list->items[a].arrival_ms, tb = list->items[b].arrival_ms;
+    return ta != tb ? ta < tb : a < b;
+}
+
+static void update_arrival(ScheduleCache *c, const PatientList *list, EditKind kind, size_t idx, size_t n_old) {
+    size_t n = n_old;
+    if (kind != EDIT_ADD) {
+        size_t j = 0;
+        while (j < n && c->by_arrival[j] != (int)idx) j++;
+        for (; j + 1 < n; ++j) c->by_arrival[j] = c->by_arrival[j + 1];
+        n--;
+        if (kind == EDIT_REMOVE) {
+            for (size_t k = 0; k < n; ++k)
+                if (c->by_arrival[k] > (int)idx) c->by_arrival[k]--;
+            return;
+        }
+    }
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (arrives_before(list, c->by_arrival[mid], (int)idx)) lo = mid + 1;
+        else hi = mid;
+    }
+    memmove(&c->by_arrival[lo + 1], &c->by_arrival[lo], sizeof(int) * (n - lo));
+    c->by_arrival[lo] = (int)idx;
+}
+
+// Take one patient back out of the histograms. Returns 1 if a value equal to
+// some histogram's max was removed, so the maxima need a rescan.
+static int unrecord_patient(MetricsHistograms *h, const Patient *p, uint64_t wait, uint64_t turnaround) {
+    unsigned b = hist_bucket(wait);
+    Histogram *by_priority = &h->wait_by_priority[metrics_priority_class(p->priority)];
+    Histogram *by_service = &h->wait_by_service[metrics_service_class(p->service)];
+    hist_remove_in(&h->wait, b);
+    hist_remove_in(by_priority, b);
+    hist_remove_in(by_service, b);
+    hist_remove_in(&h->turnaround, hist_bucket(turnaround));
+    return wait == h->wait.max || wait == by_priority->max || wait == by_service->max ||
+           turnaround == h->turnaround.max;
+}
+
+static void rescan_max(ScheduleCacheEntry *e, const PatientList *list) {
+    MetricsHistograms *h = &e->hist;
+    h->wait.max = h->turnaround.max = 0;
+    for (int k = 0; k < METRICS_PRIORITY_CLASSES; ++k) h->wait_by_priority[k].max = 0;
+    for (int s = 0; s < SERVICE_TYPE_COUNT; ++s) h->wait_by_service[s].max = 0;
+    for (size_t k = 0; k < list->count; ++k) {
+        const Patient *p = &list->items[e->order[k]];
+        uint64_t wait = e->start[k] - p->arrival_ms;
+        uint64_t turnaround = wait + p->required_time_ms;
+        Histogram *by_priority = &h->wait_by_priority[metrics_priority_class(p->priority)];
+        Histogram *by_service = &h->wait_by_service[metrics_service_class(p->service)];
+        if (wait > h->wait.max) h->wait.max = wait;
+        if (wait > by_priority->max) by_priority->max = wait;
+        if (wait > by_service->max) by_service->max = wait;
+        if (turnaround > h->turnaround.max) h->turnaround.max = turnaround;
+    }
+}
+
+typedef struct {
+    int *order;
+    unsigned long long *start;
+    size_t next;
+} SuffixRecord;
+
+static void record_suffix(void *ctx, const DispatchJob *job, unsigned long long t) {
+    SuffixRecord *rec = (SuffixRecord *)ctx;
+    rec->order[rec->next] = job->idx;
+    rec->start[rec->next] = t;
+    rec->next++;
+}
+
+// Run every patient outside order[0..k) through the dispatch engine, with the
+// clock starting at `time`, writing positions k.. of the order.
+static int replay_suffix(ScheduleCache *c, ScheduleCacheEntry *e, Algorithm alg,
+                         const PatientList *list, size_t k, unsigned long long time) {
+    size_t n = list->count;
+    memset(c->in_prefix, 0, n);
+    for (size_t j = 0; j < k; ++j) c->in_prefix[e->order[j]] = 1;
+
+    SuffixRecord rec = { .order = e->order, .start = e->start, .next = k };
+    DispatchHooks hooks = { .on_start = record_suffix, .on_slice = NULL, .on_finish = NULL, .ctx = &rec };
+    Dispatcher d;
+    if (dispatcher_init(&d, alg, &hooks) != 0) return -1;
+    dispatcher_start_at(&d, time);
+    int rc = 0;
+    for (size_t a = 0; a < n && rc == 0; ++a) {
+        int i = c->by_arrival[a];
+        if (c->in_prefix[i]) continue;
+        const Patient *p = &list->items[i];
+        DispatchJob job = {
+            .idx = i,
+            .id = p->id,
+            .arrival_ms = p->arrival_ms,
+            .burst_ms = p->required_time_ms,
+            .remaining_ms = p->required_time_ms,
+            .priority = p->priority
+        };
+        rc = dispatcher_arrive(&d, &job);
+    }
+    if (rc == 0) dispatcher_drain(&d);
+    dispatcher_destroy(&d);
+    return rc == 0 && rec.next == n ? 0 : -1;
+}
+
+// Patch a non-preemptive schedule after an edit. A decision at position j
+// only sees patients that arrived by start[j], and choosing among them is a
+// strict order, so decisions before both the edited patient's old position
+// and its new arrival stay as they were. Everything from the first affected
+// position k is replayed with the clock at the end of position k-1.
+static int patch_entry(ScheduleCache *c, Algorithm alg, const PatientList *list, EditKind kind,
+                       size_t idx, const Patient *before, size_t n_old) {
+    ScheduleCacheEntry *e = &c->entries[alg];
+    size_t n = list->count;
+    size_t k = n_old;
+    if (kind != EDIT_ADD) {
+        for (size_t j = 0; j < n_old; ++j)
+            if (e->order[j] == (int)idx) { k = j; break; }
+    }
+    if (kind != EDIT_REMOVE) {
+        // Start times grow with the position: find the first one at or after the new arrival
+        unsigned arrival = list->items[idx].arrival_ms;
+        size_t lo = 0, hi = k;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (e->start[mid] >= arrival) hi = mid;
+            else lo = mid + 1;
+        }
+        k = lo;
+    }
+
+    // Take out the old suffix
+    int max_dirty = 0;
+    for (size_t j = k; j < n_old; ++j) {
+        const Patient *p = old_patient(list, kind, idx, before, (size_t)e->order[j]);
+        uint64_t wait = e->start[j] - p->arrival_ms;
+        uint64_t turnaround = wait + p->required_time_ms;
+        e->total_wait_ms -= wait;
+        e->total_turnaround_ms -= turnaround;
+        max_dirty |= unrecord_patient(&e->hist, p, wait, turnaround);
+    }
+    if (kind == EDIT_REMOVE) {
+        for (size_t j = 0; j < k; ++j)
+            if (e->order[j] > (int)idx) e->order[j]--;
+    }
+
+    // Replay the rest
+    unsigned long long time = 0;
+    if (k > 0) time = e->start[k - 1] + list->items[e->order[k - 1]].required_time_ms;
+    if (alg == ALG_FCFS) {
+        // FCFS serves in arrival order, which is already maintained
+        for (size_t j = k; j < n; ++j) {
+            const Patient *p = &list->items[c->by_arrival[j]];
+            if (p->arrival_ms > time) time = p->arrival_ms;
+            e->order[j] = c->by_arrival[j];
+            e->start[j] = time;
+            time += p->required_time_ms;
+        }
+    } else if (replay_suffix(c, e, alg, list, k, time) != 0) {
+        return -1;
+    }
+
+    // Put in the new suffix
+    for (size_t j = k; j < n; ++j) {
+        const Patient *p = &list->items[e->order[j]];
+        uint64_t wait = e->start[j] - p->arrival_ms;
+        uint64_t turnaround = wait + p->required_time_ms;
+        e->total_wait_ms += wait;
+        e->total_turnaround_ms += turnaround;
+        metrics_histograms_record(&e->hist, p->priority, p->service, wait, turnaround);
+    }
+    if (max_dirty) rescan_max(e, list);
+    summarize(e, n);
+    return 0;
+}
+
+static void apply_edit(ScheduleCache *c, const PatientList *list, EditKind kind, size_t idx, const Patient *before) {
+    size_t n_old = c->count, n = list->count;
+    size_t expect = kind == EDIT_ADD ? n_old + 1 : kind == EDIT_REMOVE ? n_old - 1 : n_old;
+    c->count = n;
+    if (kind == EDIT_ADD) idx = n - 1;
+    if (n != expect || (kind != EDIT_ADD && idx >= n_old) || ensure_cap(c, n) != 0) {
+        schedule_cache_invalidate(c);
+        return;
+    }
+
+    int any = 0;
+    for (int a = 0; a < ALG_COUNT; ++a) {
+        ScheduleCacheEntry *e = &c->entries[a];
+        if (!is_incremental((Algorithm)a)) drop_entry(e);
+        else {
+            e->version++;
+            any |= e->valid;
+        }
+    }
+    if (c->arrival_valid) update_arrival(c, list, kind, idx, n_old);
+    else if (any && build_arrival(c, list) != 0) {
+        schedule_cache_invalidate(c);
+        return;
+    }
+    for (int a = 0; a < ALG_COUNT; ++a) {
+        ScheduleCacheEntry *e = &c->entries[a];
+        if (e->valid && patch_entry(c, (Algorithm)a, list, kind, idx, before, n_old) != 0) drop_entry(e);
+    }
+}
+
+void schedule_cache_added(ScheduleCache *c, const PatientList *list) {
+    apply_edit(c, list, EDIT_ADD, 0, NULL);
+}
+
+void schedule_cache_changed(ScheduleCache *c, const PatientList *list, size_t idx, const Patient *before) {
+    const Patient *p = idx < list->count ? &list->items[idx] : NULL;
+    // Names and ids do not affect any schedule
+    if (p && c->count == list->count && p->arrival_ms == before->arrival_ms &&
+        p->required_time_ms == before->required_time_ms && p->priority == before->priority &&
+        p->service == before->service)
+        return;
+    apply_edit(c, list, EDIT_CHANGE, idx, before);
+}
+
+void schedule_cache_removed(ScheduleCache *c, const PatientList *list, size_t idx, const Patient *before) {
+    apply_edit(c, list, EDIT_REMOVE, idx, before);
+}
@@ -1,185 +1,473 @@
 #include "scheduler.h"
+#include "dispatch.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
-// Portable comparators using a static context pointer
-static const PatientList *g_cmp_ctx = NULL;
+// ─────────────────────────────────────────────────────────────────────────────
+// Ordering
+//
+// Every ordering sorts packed 64-bit words (key << 32 | index), so there is no
+// shared comparator context and ties keep index order. Any number of schedules
+// can be computed concurrently.
+//
+// Packed words are always built in index order, so a stable LSD radix sort on
+// the 32 key bits alone yields the same result as a full 64-bit qsort.
+// ─────────────────────────────────────────────────────────────────────────────
+static SortBackend g_sort_backend = SORT_RADIX;
 
-static int cmp_fcfs(const void *a, const void *b) {
-    int ia = *(const int *)a, ib = *(const int *)b;
-    unsigned aa = g_cmp_ctx->items[ia].arrival_ms;
-    unsigned ab = g_cmp_ctx->items[ib].arrival_ms;
-    if (aa < ab) return -1;
-    if (aa > ab) return 1;
-    return ia - ib;
+void set_sort_backend(SortBackend backend) { g_sort_backend = backend; }
+SortBackend get_sort_backend(void) { return g_sort_backend; }
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
 }
 
-static int cmp_sjf(const void *a, const void *b) {
-    int ia = *(const int *)a, ib = *(const int *)b;
-    unsigned ba = g_cmp_ctx->items[ia].required_time_ms;
-    unsigned bb = g_cmp_ctx->items[ib].required_time_ms;
-    if (ba < bb) return -1;
-    if (ba > bb) return 1;
-    return ia - ib;
+// Stable 4 x 8-bit LSD radix sort on the high 32 bits. Digits that are the
+// same for every word (e.g. the top bytes of small arrival times) are skipped.
+static int radix_sort_packed(uint64_t *packed, size_t n) {
+    size_t counts[4][256];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t key = (uint32_t)(packed[i] >> 32);
+        counts[0][key & 0xff]++;
+        counts[1][(key >> 8) & 0xff]++;
+        counts[2][(key >> 16) & 0xff]++;
+        counts[3][key >> 24]++;
+    }
+
+    uint64_t *tmp = NULL;
+    uint64_t *src = packed, *dst = NULL;
+    for (int d = 0; d < 4; ++d) {
+        uint32_t first = (uint32_t)((packed[0] >> (32 + 8 * d)) & 0xff);
+        if (counts[d][first] == n) continue;   // every word shares this digit
+        if (!tmp) {
+            tmp = (uint64_t *)malloc(sizeof(uint64_t) * n);
+            if (!tmp) return -1;
+            dst = tmp;
+        }
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            size_t c = counts[d][b];
+            counts[d][b] = offset;
+            offset += c;
+        }
+        int shift = 32 + 8 * d;
+        for (size_t i = 0; i < n; ++i) dst[counts[d][(src[i] >> shift) & 0xff]++] = src[i];
+        uint64_t *t = src; src = dst; dst = t;
+    }
+    if (src != packed) memcpy(packed, src, sizeof(uint64_t) * n);
+    free(tmp);
+    return 0;
 }
 
-static int cmp_priority(const void *a, const void *b) {
-    int ia = *(const int *)a, ib = *(const int *)b;
-    int pa = g_cmp_ctx->items[ia].priority;
-    int pb = g_cmp_ctx->items[ib].priority;
-    if (pa < pb) return -1; // lower value means higher priority
-    if (pa > pb) return 1;
-    return ia - ib;
+static int sort_packed(uint64_t *packed, size_t n) {
+    if (n == 0) return 0;
+    if (g_sort_backend == SORT_RADIX) return radix_sort_packed(packed, n);
+    qsort(packed, n, sizeof(uint64_t), cmp_u64);
+    return 0;
 }
 
-int *schedule_order(const PatientList *list, Algorithm alg, unsigned quantum_ms) {
-    (void)quantum_ms; // not used in pure ordering
-    int *order = (int *)malloc(sizeof(int) * list->count);
-    if (!order) return NULL;
-    for (size_t i = 0; i < list->count; ++i) order[i] = (int)i;
+static int sort_packed_indices(uint64_t *packed, size_t n, int *order) {
+    if (sort_packed(packed, n) != 0) return -1;
+    for (size_t i = 0; i < n; ++i) order[i] = (int)(packed[i] & 0xffffffffULL);
+    return 0;
+}
 
-    g_cmp_ctx = list;
-    switch (alg) {
-        case ALG_FCFS:
-            qsort(order, list->count, sizeof(int), cmp_fcfs);
-            break;
-        case ALG_SJF:
-            qsort(order, list->count, sizeof(int), cmp_sjf);
-            break;
-        case ALG_PRIORITY:
-            qsort(order, list->count, sizeof(int), cmp_priority);
-            break;
-        case ALG_RR:
-            // For RR, we keep arrival order; detailed slicing handled in metrics
-            qsort(order, list->count, sizeof(int), cmp_fcfs);
-            break;
-        default:
-            break;
+int sort_indices_by_key(const unsigned *keys, size_t n, int *order) {
+    if (n == 0) return 0;
+    uint64_t *packed = (uint64_t *)malloc(sizeof(uint64_t) * n);
+    if (!packed) return -1;
+    for (size_t i = 0; i < n; ++i) packed[i] = ((uint64_t)keys[i] << 32) | (uint64_t)i;
+    int rc = sort_packed_indices(packed, n, order);
+    free(packed);
+    return rc;
+}
+
+// Indices ordered by (arrival_ms, index)
+static int sort_by_arrival(const PatientColumns *cols, int *order) {
+    return sort_indices_by_key(cols->arrival_ms, cols->count, order);
+}
+
+typedef struct {
+    int *order;
+    size_t next;
+    unsigned long long *finish;
+} DispatchRecord;
+
+static void record_start(void *ctx, const DispatchJob *job, unsigned long long t) {
+    (void)t;
+    DispatchRecord *rec = (DispatchRecord *)ctx;
+    if (rec->order) rec->order[rec->next++] = job->idx;
+}
+
+static void record_finish(void *ctx, const DispatchJob *job, unsigned long long t) {
+    DispatchRecord *rec = (DispatchRecord *)ctx;
+    if (rec->finish) rec->finish[job->idx] = t;
+}
+
+// Runs the dispatch engine, capturing first-dispatch order and/or finish times.
+static int run_dispatch(const PatientColumns *cols, Algorithm alg, int *order, unsigned long long *finish) {
+    DispatchRecord rec = { .order = order, .next = 0, .finish = finish };
+    DispatchHooks hooks = { .on_start = record_start, .on_slice = NULL, .on_finish = record_finish, .ctx = &rec };
+    return dispatch_run_columns(cols, alg, &hooks);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Round Robin engine
+//
+// Phase 1 runs while arrivals are still pending, since each arrival changes
+// the queue. Whole rounds that end before the next arrival and finish nobody
+// leave the queue order as it was, so they are applied in one O(queue) step;
+// only the rounds around an arrival or a finish are stepped slice by slice.
+// Once everybody has arrived the
+// queue is stable and the remaining schedule has a closed form. A patient that
+// needs c more slices finishes in round c. Before it finishes, every patient
+// that needed fewer rounds has completed, every patient still alive in round c
+// has had (c-1) full quanta, and in round c it runs after the earlier-positioned
+// survivors. Sorting by (c, position) plus a Fenwick tree over queue positions
+// yields all finish times in O(m log m) instead of O(total slices x queue).
+// ─────────────────────────────────────────────────────────────────────────────
+static void fenwick_add(unsigned *tree, size_t m, size_t pos, int delta) {
+    for (size_t i = pos + 1; i <= m; i += i & (~i + 1)) tree[i - 1] += (unsigned)delta;
+}
+
+// Number of live entries at positions [0, pos)
+static unsigned fenwick_prefix(const unsigned *tree, size_t pos) {
+    unsigned sum = 0;
+    for (size_t i = pos; i > 0; i -= i & (~i + 1)) sum += tree[i - 1];
+    return sum;
+}
+
+// Finish times for patients still queued when the last arrival has been
+// enqueued. queue[0..m) is in service order starting at time `start`.
+static int rr_drain_stable(const int *queue, size_t m, const unsigned *remaining, unsigned q,
+                           unsigned long long start, unsigned long long *finish) {
+    if (m == 0) return 0;
+    uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * m);
+    unsigned *tree = (unsigned *)calloc(m, sizeof(unsigned));
+    if (!keys || !tree) { free(keys); free(tree); return -1; }
+
+    for (size_t pos = 0; pos < m; ++pos) {
+        unsigned rem = remaining[queue[pos]];
+        uint64_t rounds = rem ? (rem + (uint64_t)q - 1) / q : 1;   // slices still needed (>= 1)
+        keys[pos] = (rounds << 32) | (uint64_t)pos;
+        fenwick_add(tree, m, pos, 1);
     }
-    g_cmp_ctx = NULL;
-    return order;
+    if (sort_packed(keys, m) != 0) { free(keys); free(tree); return -1; }
+
+    unsigned long long done_sum = 0;   // total service of patients finished in earlier rounds
+    size_t alive = m;
+    size_t g = 0;
+    while (g < m) {
+        uint64_t c = keys[g] >> 32;
+        size_t end = g;
+        while (end < m && (keys[end] >> 32) == c) end++;
+
+        unsigned long long base = start + done_sum + (c - 1) * (unsigned long long)q * alive;
+        unsigned long long group_last = 0;   // final slices of earlier group members this round
+        for (size_t k = g; k < end; ++k) {
+            size_t pos = (size_t)(keys[k] & 0xffffffffULL);
+            int pid = queue[pos];
+            unsigned long long last = remaining[pid] - (c - 1) * (unsigned long long)q;
+            unsigned before = fenwick_prefix(tree, pos);
+            unsigned longer_before = before - (unsigned)(k - g);   // survivors past round c ahead of us
+            finish[pid] = base + group_last + (unsigned long long)longer_before * q + last;
+            group_last += last;
+        }
+        for (size_t k = g; k < end; ++k) {
+            size_t pos = (size_t)(keys[k] & 0xffffffffULL);
+            fenwick_add(tree, m, pos, -1);
+            done_sum += remaining[queue[pos]];
+        }
+        alive -= end - g;
+        g = end;
+    }
+    free(keys); free(tree);
+    return 0;
 }
 
-ScheduleMetrics compute_metrics(const PatientList *list, const int *order, Algorithm alg, unsigned quantum_ms) {
-    ScheduleMetrics m = {0};
-    size_t n = list->count;
-    if (n == 0) return m;
+static int rr_finish_times(const PatientColumns *cols, const int *order, unsigned quantum_ms,
+                           unsigned long long *finish) {
+    size_t n = cols->count;
+    const unsigned *arrival = cols->arrival_ms;
+    unsigned q = quantum_ms ? quantum_ms : 1;
+    unsigned *remaining = (unsigned *)malloc(sizeof(unsigned) * n);
+    int *arrival_order = (int *)malloc(sizeof(int) * n);
+    int *queue = (int *)malloc(sizeof(int) * n);
+    if (!remaining || !arrival_order || !queue) {
+        free(remaining); free(arrival_order); free(queue);
+        return -1;
+    }
+    memcpy(remaining, cols->burst_ms, sizeof(unsigned) * n);
 
-    if (alg == ALG_RR) {
-        // Accurate Round Robin with circular ready queue
-        unsigned *remaining = (unsigned *)malloc(sizeof(unsigned) * n);
-        unsigned *arrival = (unsigned *)malloc(sizeof(unsigned) * n);
-        unsigned *finish = (unsigned *)calloc(n, sizeof(unsigned));
-        unsigned *waiting = (unsigned *)calloc(n, sizeof(unsigned));
-        for (size_t i = 0; i < n; ++i) {
-            remaining[i] = list->items[i].required_time_ms;
-            arrival[i] = list->items[i].arrival_ms;
+    // Make a local copy of the order and sort by arrival for queueing
+    // (skipped when the caller already passes the RR/FCFS arrival order)
+    int sorted = 1;
+    for (size_t i = 0; i < n; ++i) {
+        arrival_order[i] = order[i];
+        if (i > 0) {
+            unsigned prev = arrival[order[i - 1]], cur = arrival[order[i]];
+            if (prev > cur || (prev == cur && order[i - 1] > order[i])) sorted = 0;
         }
+    }
+    if (!sorted && sort_by_arrival(cols, arrival_order) != 0) {
+        free(remaining); free(arrival_order); free(queue);
+        return -1;
+    }
 
-        // Make a local copy of the order and sort by arrival for queueing
-        int *arrival_order = (int *)malloc(sizeof(int) * n);
-        for (size_t i = 0; i < n; ++i) arrival_order[i] = order[i];
-        g_cmp_ctx = list; qsort(arrival_order, n, sizeof(int), cmp_fcfs); g_cmp_ctx = NULL;
-
-        int *queue = (int *)malloc(sizeof(int) * n);
-        size_t head = 0, tail = 0, qcount = 0;
-
-        unsigned time = 0;
-        size_t completed = 0;
-        size_t next_arrival = 0;
-
-        // Jump to first arrival if needed
-        if (next_arrival < n) time = arrival[arrival_order[next_arrival]];
-
-        while (completed < n) {
-            // Enqueue all that have arrived by current time
-            while (next_arrival < n) {
-                int pid = arrival_order[next_arrival];
-                if (arrival[pid] <= time) {
-                    queue[tail] = pid; tail = (tail + 1) % n; qcount++;
-                    next_arrival++;
-                } else break;
-            }
+    // Circular ready queue; phase 1 runs until the last arrival is enqueued
+    size_t head = 0, tail = 0, qcount = 0, next_arrival = 0;
+    size_t plain = 0;   // slices to step one at a time before trying to skip rounds again
+    unsigned long long time = arrival[arrival_order[0]];
+    while (next_arrival < n) {
+        while (next_arrival < n && arrival[arrival_order[next_arrival]] <= time) {
+            queue[tail] = arrival_order[next_arrival++]; tail = (tail + 1) % n; qcount++;
+        }
+        if (next_arrival == n) break;
+        if (qcount == 0) {
+            // No ready processes; jump to next arrival
+            time = arrival[arrival_order[next_arrival]];
+            continue;
+        }
 
-            if (qcount == 0) {
-                // No ready processes; jump to next arrival
-                if (next_arrival < n) {
-                    time = arrival[arrival_order[next_arrival]];
-                    continue;
-                }
+        // Whole rounds that end before the next arrival and finish nobody
+        // leave the queue order unchanged: run them in one step
+        unsigned long long round = (unsigned long long)qcount * q;
+        unsigned long long gap = arrival[arrival_order[next_arrival]] - time;
+        if (plain > 0) {
+            plain--;
+        } else if (gap > round) {
+            unsigned min_rem = UINT_MAX;
+            for (size_t k = 0; k < qcount; ++k) {
+                unsigned r = remaining[queue[(head + k) % n]];
+                if (r < min_rem) min_rem = r;
             }
-
-            // Dequeue next ready process
-            int pid = queue[head]; head = (head + 1) % n; qcount--;
-            if (remaining[pid] == 0) {
-                // Already completed; skip
+            unsigned long long rounds = (gap - 1) / round;
+            unsigned long long alive = min_rem ? (min_rem - 1) / q : 0;   // rounds before anyone's last slice
+            if (alive < rounds) rounds = alive;
+            if (rounds > 0) {
+                for (size_t k = 0; k < qcount; ++k) remaining[queue[(head + k) % n]] -= (unsigned)(rounds * q);
+                time += rounds * round;
                 continue;
             }
-            unsigned slice = remaining[pid] > quantum_ms ? quantum_ms : remaining[pid];
-            // Other ready processes wait during this slice
-            for (size_t i = 0, idx = head; i < qcount; ++i) {
-                int other = queue[idx];
-                idx = (idx + 1) % n;
-                if (remaining[other] > 0) waiting[other] += slice;
-            }
-            time += slice;
-            remaining[pid] -= slice;
-
-            // Enqueue any new arrivals that occurred during the slice
-            while (next_arrival < n) {
-                int np = arrival_order[next_arrival];
-                if (arrival[np] <= time) {
-                    queue[tail] = np; tail = (tail + 1) % n; qcount++;
-                    next_arrival++;
-                } else break;
-            }
+            plain = qcount;   // someone finishes within this round; step it slice by slice
+        }
 
-            if (remaining[pid] > 0) {
-                // Requeue current process
-                queue[tail] = pid; tail = (tail + 1) % n; qcount++;
-            } else {
-                finish[pid] = time;
-                completed++;
-            }
+        int pid = queue[head]; head = (head + 1) % n; qcount--;
+        unsigned slice = remaining[pid] > q ? q : remaining[pid];
+        time += slice;
+        remaining[pid] -= slice;
+
+        // Enqueue any new arrivals that occurred during the slice
+        while (next_arrival < n && arrival[arrival_order[next_arrival]] <= time) {
+            queue[tail] = arrival_order[next_arrival++]; tail = (tail + 1) % n; qcount++;
         }
 
-        double total_wait = 0.0, total_turn = 0.0;
-        for (size_t i = 0; i < n; ++i) {
-            unsigned turnaround = finish[i] - arrival[i];
-            total_turn += turnaround;
-            total_wait += waiting[i];
+        if (remaining[pid] > 0) {
+            // Requeue current process
+            queue[tail] = pid; tail = (tail + 1) % n; qcount++;
+        } else {
+            finish[pid] = time;
         }
-        m.avg_wait_ms = total_wait / n;
-        m.avg_turnaround_ms = total_turn / n;
-        free(remaining); free(arrival); free(finish); free(waiting); free(queue); free(arrival_order);
+    }
+
+    // Phase 2: everybody has arrived; unroll the circular queue and solve it
+    for (size_t k = 0; k < qcount; ++k) arrival_order[k] = queue[(head + k) % n];
+    int rc = rr_drain_stable(arrival_order, qcount, remaining, q, time, finish);
+
+    free(remaining); free(arrival_order); free(queue);
+    return rc;
+}
+
+int *schedule_order_columns(const PatientColumns *cols, Algorithm alg, unsigned quantum_ms) {
+    (void)quantum_ms; // not used in pure ordering
+    int *order = (int *)malloc(sizeof(int) * (cols->count ? cols->count : 1));
+    if (!order) return NULL;
+
+    if (alg != ALG_FCFS && alg != ALG_RR && dispatch_supports(alg)) {
+        if (run_dispatch(cols, alg, order, NULL) != 0) { free(order); return NULL; }
+        return order;
+    }
+    // FCFS, and RR which keeps arrival order (slicing is handled in metrics)
+    if (sort_by_arrival(cols, order) != 0) { free(order); return NULL; }
+    return order;
+}
+
+int *schedule_order(const PatientList *list, Algorithm alg, unsigned quantum_ms) {
+    PatientColumns cols;
+    if (patient_columns_build(list, &cols, 0) != 0) return NULL;
+    int *order = schedule_order_columns(&cols, alg, quantum_ms);
+    patient_columns_free(&cols);
+    return order;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Metrics: averages plus latency histograms, overall and by priority class and
+// service type, recorded in the same pass over the patients.
+// ─────────────────────────────────────────────────────────────────────────────
+void metrics_histograms_record(MetricsHistograms *h, int priority, unsigned service,
+                               uint64_t wait, uint64_t turnaround) {
+    unsigned b = hist_bucket(wait);
+    hist_record_in(&h->wait, b, wait);
+    hist_record_in(&h->wait_by_priority[metrics_priority_class(priority)], b, wait);
+    hist_record_in(&h->wait_by_service[metrics_service_class(service)], b, wait);
+    hist_record(&h->turnaround, turnaround);
+}
+
+static inline void record_patient(MetricsHistograms *h, const PatientColumns *cols, int i,
+                                  uint64_t wait, uint64_t turnaround) {
+    metrics_histograms_record(h, cols->priority[i], cols->service[i], wait, turnaround);
+}
+
+// Averages from per-patient finish times: wait is whatever part of the
+// turnaround was not service
+static ScheduleMetrics metrics_from_finish(const PatientColumns *cols, const unsigned long long *finish,
+                                           MetricsHistograms *h) {
+    ScheduleMetrics m = {0};
+    size_t n = cols->count;
+    double total_wait = 0.0, total_turn = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned long long turnaround = finish[i] - cols->arrival_ms[i];
+        unsigned long long wait = turnaround - cols->burst_ms[i];
+        total_turn += (double)turnaround;
+        total_wait += (double)wait;
+        record_patient(h, cols, (int)i, wait, turnaround);
+    }
+    m.avg_wait_ms = total_wait / n;
+    m.avg_turnaround_ms = total_turn / n;
+    return m;
+}
+
+LatencySummary latency_summary(const Histogram *h) {
+    LatencySummary s = {
+        .count = h->total,
+        .p50 = hist_percentile(h, 0.50),
+        .p95 = hist_percentile(h, 0.95),
+        .p99 = hist_percentile(h, 0.99),
+        .max = h->max
+    };
+    return s;
+}
+
+void metrics_histograms_merge(MetricsHistograms *dst, const MetricsHistograms *src) {
+    hist_merge(&dst->wait, &src->wait);
+    hist_merge(&dst->turnaround, &src->turnaround);
+    for (int c = 0; c < METRICS_PRIORITY_CLASSES; ++c) hist_merge(&dst->wait_by_priority[c], &src->wait_by_priority[c]);
+    for (int s = 0; s < SERVICE_TYPE_COUNT; ++s) hist_merge(&dst->wait_by_service[s], &src->wait_by_service[s]);
+}
+
+void metrics_summarize(const MetricsHistograms *hist, ScheduleMetrics *m) {
+    m->wait = latency_summary(&hist->wait);
+    m->turnaround = latency_summary(&hist->turnaround);
+    for (int c = 0; c < METRICS_PRIORITY_CLASSES; ++c) m->wait_by_priority[c] = latency_summary(&hist->wait_by_priority[c]);
+    for (int s = 0; s < SERVICE_TYPE_COUNT; ++s) m->wait_by_service[s] = latency_summary(&hist->wait_by_service[s]);
+}
+
+ScheduleMetrics compute_metrics_hist(const PatientColumns *cols, const int *order, Algorithm alg, unsigned quantum_ms,
+                                     MetricsHistograms *hist) {
+    ScheduleMetrics m = {0};
+    MetricsHistograms local;
+    MetricsHistograms *h = hist ? hist : &local;
+    memset(h, 0, sizeof(*h));
+    size_t n = cols->count;
+    if (n == 0) return m;
+
+    if (alg == ALG_RR || dispatch_is_preemptive(alg)) {
+        // RR from the closed-form engine, preemptive ones from the event-driven engine
+        unsigned long long *finish = (unsigned long long *)calloc(n, sizeof(unsigned long long));
+        int rc = !finish ? -1
+               : alg == ALG_RR ? rr_finish_times(cols, order, quantum_ms, finish)
+               : run_dispatch(cols, alg, NULL, finish);
+        if (rc == 0) {
+            m = metrics_from_finish(cols, finish, h);
+            metrics_summarize(h, &m);
+        }
+        free(finish);
         return m;
     }
 
-    // Non-preemptive algorithms
-    unsigned time = 0;
+    // Non-preemptive algorithms: `order` is the dispatch order, so walking it
+    // (idling until each patient arrives) reproduces the schedule.
+    const unsigned *arrival = cols->arrival_ms, *burst = cols->burst_ms;
+    unsigned long long time = 0;   // a long list can outrun 32 bits of milliseconds
     double total_wait = 0.0, total_turn = 0.0;
     for (size_t k = 0; k < n; ++k) {
         int i = order[k];
-        Patient p = list->items[i];
-        if (p.arrival_ms > time) time = p.arrival_ms;
-        unsigned waiting = time - p.arrival_ms;
-        total_wait += waiting;
-        time += p.required_time_ms;
-        unsigned turnaround = time - p.arrival_ms;
-        total_turn += turnaround;
+        if (arrival[i] > time) time = arrival[i];
+        unsigned long long waiting = time - arrival[i];
+        total_wait += (double)waiting;
+        time += burst[i];
+        unsigned long long turnaround = time - arrival[i];
+        total_turn += (double)turnaround;
+        record_patient(h, cols, i, waiting, turnaround);
     }
     m.avg_wait_ms = total_wait / n;
     m.avg_turnaround_ms = total_turn / n;
+    metrics_summarize(h, &m);
     return m;
 }
 
+ScheduleMetrics compute_metrics_columns(const PatientColumns *cols, const int *order, Algorithm alg, unsigned quantum_ms) {
+    return compute_metrics_hist(cols, order, alg, quantum_ms, NULL);
+}
+
+ScheduleMetrics compute_metrics(const PatientList *list, const int *order, Algorithm alg, unsigned quantum_ms) {
+    ScheduleMetrics m = {0};
+    PatientColumns cols;
+    if (patient_columns_build(list, &cols, 0) != 0) return m;
+    m = compute_metrics_columns(&cols, order, alg, quantum_ms);
+    patient_columns_free(&cols);
+    return m;
+}
+
+typedef struct {
+    const PatientColumns *cols;
+    Algorithm alg;
+    unsigned quantum_ms;
+    ScheduleMetrics result;
+} MetricsJob;
+
+static void *metrics_job(void *arg) {
+    MetricsJob *job = (MetricsJob *)arg;
+    int *order = schedule_order_columns(job->cols, job->alg, job->quantum_ms);
+    if (order) job->result = compute_metrics_columns(job->cols, order, job->alg, job->quantum_ms);
+    free(order);
+    return NULL;
+}
+
+void compute_all_metrics(const PatientList *list, unsigned quantum_ms, ScheduleMetrics out[ALG_COUNT]) {
+    memset(out, 0, sizeof(ScheduleMetrics) * ALG_COUNT);
+    PatientColumns cols;   // gathered once, shared read-only by every job
+    if (patient_columns_build(list, &cols, 0) != 0) return;
+
+    MetricsJob jobs[ALG_COUNT];
+    pthread_t threads[ALG_COUNT];
+    int started[ALG_COUNT];
+    for (int i = 0; i < ALG_COUNT; ++i) {
+        jobs[i] = (MetricsJob){ .cols = &cols, .alg = (Algorithm)i, .quantum_ms = quantum_ms };
+        started[i] = pthread_create(&threads[i], NULL, metrics_job, &jobs[i]) == 0;
+        if (!started[i]) metrics_job(&jobs[i]);   // fall back to running inline
+    }
+    for (int i = 0; i < ALG_COUNT; ++i) {
+        if (started[i]) pthread_join(threads[i], NULL);
+        out[i] = jobs[i].result;
+    }
+    patient_columns_free(&cols);
+}
+
 const char *alg_name(Algorithm alg) {
     switch (alg) {
         case ALG_FCFS: return "FCFS";
         case ALG_SJF: return "SJF";
         case ALG_PRIORITY: return "Priority";
         case ALG_RR: return "Round Robin";
+        case ALG_SRTF: return "SRTF";
+        case ALG_PRIORITY_PREEMPTIVE: return "Priority (Preemptive)";
         default: return "Unknown";
     }
 }
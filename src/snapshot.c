@@ -0,0 +1,242 @@
+#include "snapshot.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static size_t align_up(size_t v) {
+    return (v + HRS_ALIGN - 1) & ~(size_t)(HRS_ALIGN - 1);
+}
+
+// Byte size of each section for n patients
+static void section_sizes(uint64_t n, uint64_t names_bytes, uint32_t flags, size_t *sz) {
+    sz[HRS_SEC_ID] = sizeof(int) * n;
+    sz[HRS_SEC_PRIORITY] = sizeof(int) * n;
+    sz[HRS_SEC_ARRIVAL] = sizeof(unsigned) * n;
+    sz[HRS_SEC_BURST] = sizeof(unsigned) * n;
+    sz[HRS_SEC_SERVICE] = n;
+    sz[HRS_SEC_NAME_OFF] = sizeof(uint32_t) * n;
+    sz[HRS_SEC_NAMES] = names_bytes;
+    sz[HRS_SEC_PATH_LEN] = (flags & HRS_HAS_PATHS) ? n : 0;
+    sz[HRS_SEC_PATH] = (flags & HRS_HAS_PATHS) ? sizeof(PathStep) * MAX_PATH_STEPS * n : 0;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+int snapshot_write(const char *path, const PatientList *list) {
+    PatientColumns cols;
+    if (patient_columns_build(list, &cols, PATIENT_COLS_NAMES) != 0) return -1;
+    size_t n = list->count;
+
+    HrsHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = HRS_MAGIC;
+    h.version = HRS_VERSION;
+    h.count = n;
+    for (size_t i = 0; i < n; ++i)
+        if (list->items[i].path_len > 0) { h.flags |= HRS_HAS_PATHS; break; }
+    h.names_bytes = n ? cols.name_off[n - 1] + strlen(cols.names + cols.name_off[n - 1]) + 1 : 0;
+
+    unsigned char *path_len = NULL;
+    PathStep *steps = NULL;
+    if (h.flags & HRS_HAS_PATHS) {
+        path_len = (unsigned char *)malloc(n);
+        steps = (PathStep *)calloc(n * MAX_PATH_STEPS, sizeof(PathStep));
+        if (!path_len || !steps) {
+            free(path_len); free(steps); patient_columns_free(&cols);
+            return -1;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            path_len[i] = list->items[i].path_len;
+            memcpy(&steps[i * MAX_PATH_STEPS], list->items[i].path, sizeof(list->items[i].path));
+        }
+    }
+
+    const void *data[HRS_SEC_COUNT] = {
+        cols.id, cols.priority, cols.arrival_ms, cols.burst_ms, cols.service,
+        cols.name_off, cols.names, path_len, steps
+    };
+    size_t sz[HRS_SEC_COUNT];
+    section_sizes(n, h.names_bytes, h.flags, sz);
+    size_t off = align_up(sizeof(h));
+    for (int s = 0; s < HRS_SEC_COUNT; ++s) {
+        if (sz[s] == 0) continue;
+        h.offset[s] = off;
+        off = align_up(off + sz[s]);
+    }
+
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int rc = fd == -1 ? -1 : 0;
+    static const char zeros[HRS_ALIGN];
+    size_t pos = 0;
+    if (rc == 0) {
+        rc = write_all(fd, &h, sizeof(h));
+        pos = sizeof(h);
+    }
+    for (int s = 0; s < HRS_SEC_COUNT && rc == 0; ++s) {
+        if (sz[s] == 0) continue;
+        rc = write_all(fd, zeros, h.offset[s] - pos);
+        if (rc == 0) rc = write_all(fd, data[s], sz[s]);
+        pos = h.offset[s] + sz[s];
+    }
+    if (fd != -1) {
+        if (rc == 0) rc = fsync(fd);
+        if (close(fd) != 0) rc = -1;
+        if (rc == 0) rc = rename(tmp, path);
+        if (rc != 0) unlink(tmp);
+    }
+
+    free(path_len);
+    free(steps);
+    patient_columns_free(&cols);
+    return rc == 0 ? 0 : -1;
+}
+
+static int fail(char *err, size_t errsz, const char *msg) {
+    if (err && errsz) snprintf(err, errsz, "%s", msg);
+    return -1;
+}
+
+// The byte columns hold enums and step counts that index fixed tables later
+// on; one pass over them is cheap next to trusting a damaged file.
+static const char *check_columns(const HrsHeader *h, const char *base) {
+    size_t n = (size_t)h->count;
+    const unsigned char *service = (const unsigned char *)(base + h->offset[HRS_SEC_SERVICE]);
+    for (size_t i = 0; i < n; ++i)
+        if (service[i] >= SERVICE_TYPE_COUNT) return "corrupt snapshot (service)";
+    if (!(h->flags & HRS_HAS_PATHS)) return NULL;
+    const unsigned char *path_len = (const unsigned char *)(base + h->offset[HRS_SEC_PATH_LEN]);
+    const PathStep *path = (const PathStep *)(base + h->offset[HRS_SEC_PATH]);
+    for (size_t i = 0; i < n; ++i) {
+        if (path_len[i] > MAX_PATH_STEPS) return "corrupt snapshot (path length)";
+        for (int s = 0; s < path_len[i]; ++s) {
+            const PathStep *st = &path[i * MAX_PATH_STEPS + (size_t)s];
+            if (st->service >= SERVICE_TYPE_COUNT || (st->extra >> RESOURCE_TYPE_COUNT) != 0)
+                return "corrupt snapshot (path step)";
+        }
+    }
+    return NULL;
+}
+
+int snapshot_open(const char *path, Snapshot *snap, char *err, size_t errsz) {
+    memset(snap, 0, sizeof(*snap));
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return fail(err, errsz, strerror(errno));
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) {
+        close(fd);
+        return fail(err, errsz, strerror(errno));
+    }
+    size_t size = (size_t)sb.st_size;
+    if (size < sizeof(HrsHeader)) {
+        close(fd);
+        return fail(err, errsz, "not a snapshot (too short)");
+    }
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return fail(err, errsz, strerror(errno));
+
+    const HrsHeader *h = (const HrsHeader *)map;
+    const char *why = NULL;
+    size_t sz[HRS_SEC_COUNT];
+    if (h->magic != HRS_MAGIC) why = "not a snapshot (bad magic)";
+    else if (h->version != HRS_VERSION) why = "unsupported snapshot version";
+    else if (h->count > SIZE_MAX / (sizeof(PathStep) * MAX_PATH_STEPS)) why = "corrupt snapshot (count)";
+    else {
+        section_sizes(h->count, h->names_bytes, h->flags, sz);
+        for (int s = 0; s < HRS_SEC_COUNT && !why; ++s) {
+            if (sz[s] == 0) continue;
+            if (h->offset[s] % HRS_ALIGN != 0 || h->offset[s] > size || sz[s] > size - h->offset[s])
+                why = "corrupt snapshot (section out of bounds)";
+        }
+        if (!why && h->names_bytes > 0 && ((const char *)map)[h->offset[HRS_SEC_NAMES] + h->names_bytes - 1] != '\0')
+            why = "corrupt snapshot (string table)";
+        if (!why) why = check_columns(h, (const char *)map);
+    }
+    if (why) {
+        munmap(map, size);
+        return fail(err, errsz, why);
+    }
+
+    char *base = (char *)map;
+    snap->map = map;
+    snap->size = size;
+    snap->cols.count = (size_t)h->count;
+    snap->cols.id = (int *)(base + h->offset[HRS_SEC_ID]);
+    snap->cols.priority = (int *)(base + h->offset[HRS_SEC_PRIORITY]);
+    snap->cols.arrival_ms = (unsigned *)(base + h->offset[HRS_SEC_ARRIVAL]);
+    snap->cols.burst_ms = (unsigned *)(base + h->offset[HRS_SEC_BURST]);
+    snap->cols.service = (unsigned char *)(base + h->offset[HRS_SEC_SERVICE]);
+    snap->cols.name_off = (uint32_t *)(base + h->offset[HRS_SEC_NAME_OFF]);
+    snap->cols.names = base + h->offset[HRS_SEC_NAMES];
+    if (h->flags & HRS_HAS_PATHS) {
+        snap->path_len = (const unsigned char *)(base + h->offset[HRS_SEC_PATH_LEN]);
+        snap->path = (const PathStep *)(base + h->offset[HRS_SEC_PATH]);
+    }
+    return 0;
+}
+
+void snapshot_close(Snapshot *snap) {
+    if (snap->map) munmap(snap->map, snap->size);
+    memset(snap, 0, sizeof(*snap));
+}
+
+void snapshot_patient(const Snapshot *snap, size_t i, Patient *p) {
+    const HrsHeader *h = (const HrsHeader *)snap->map;
+    memset(p, 0, sizeof(*p));
+    p->id = snap->cols.id[i];
+    uint32_t off = snap->cols.name_off[i];
+    if (off < h->names_bytes) {
+        // the string table is NUL-terminated, so strnlen stays in bounds
+        size_t len = strnlen(snap->cols.names + off, MAX_NAME_LEN - 1);
+        memcpy(p->name, snap->cols.names + off, len);
+    }
+    p->priority = snap->cols.priority[i];
+    p->service = (ServiceType)snap->cols.service[i];
+    p->required_time_ms = snap->cols.burst_ms[i];
+    p->arrival_ms = snap->cols.arrival_ms[i];
+    if (snap->path_len) {
+        p->path_len = snap->path_len[i];
+        memcpy(p->path, &snap->path[i * MAX_PATH_STEPS], sizeof(p->path));
+    }
+}
+
+static void read_snapshot_patient(const void *ctx, size_t i, Patient *out) {
+    snapshot_patient((const Snapshot *)ctx, i, out);
+}
+
+PatientSource snapshot_source(const Snapshot *snap) {
+    return (PatientSource){ .count = snap->cols.count, .rows = NULL, .ctx = snap, .read = read_snapshot_patient };
+}
+
+int snapshot_to_list(const Snapshot *snap, PatientList *out) {
+    size_t n = snap->cols.count;
+    Patient *items = (Patient *)malloc(sizeof(Patient) * (n ? n : 1));
+    if (!items) return -1;
+    for (size_t i = 0; i < n; ++i) snapshot_patient(snap, i, &items[i]);
+    out->items = items;
+    out->count = n;
+    return 0;
+}
+
+int snapshot_is_path(const char *path) {
+    size_t len = strlen(path);
+    return len >= 4 && strcmp(path + len - 4, ".hrs") == 0;
+}
@@ -2,16 +2,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-static ServiceType parse_service(const char *s) {
-    if (strcmp(s, "Consultation") == 0) return SERVICE_CONSULTATION;
-    if (strcmp(s, "Lab Test") == 0) return SERVICE_LAB_TEST;
-    if (strcmp(s, "Treatment") == 0) return SERVICE_TREATMENT;
-    // Allow numeric fallback
-    int v = atoi(s);
-    if (v >= 0 && v <= 2) return (ServiceType)v;
-    return SERVICE_CONSULTATION;
-}
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 static const char *service_name_storage(ServiceType s) {
     switch (s) {
@@ -22,63 +18,436 @@ static const char *service_name_storage(ServiceType s) {
     }
 }
 
-int load_patients_csv(const char *path, PatientList *out_list) {
-    if (!path || !out_list) return -1;
-    FILE *f = fopen(path, "r");
-    if (!f) return -1;
+static const char *resource_names[RESOURCE_TYPE_COUNT] = { "Doctor", "Machine", "Room" };
+
+static void format_pathway(const Patient *p, char *buf, size_t size) {
+    size_t off = 0;
+    buf[0] = '\0';
+    for (int s = 0; s < p->path_len && off < size; ++s) {
+        int w = snprintf(buf + off, size - off, "%s%s", s ? ">" : "",
+                         service_name_storage((ServiceType)p->path[s].service));
+        for (int t = 0; t < RESOURCE_TYPE_COUNT && w >= 0 && off + (size_t)w < size; ++t)
+            if (p->path[s].extra & (1u << t))
+                w += snprintf(buf + off + w, size - off - (size_t)w, "+%s", resource_names[t]);
+        if (w < 0 || off + (size_t)w >= size) break;
+        w += snprintf(buf + off + w, size - off - (size_t)w, ":%u", p->path[s].duration_ms);
+        off += (size_t)w;
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Loader: the file is mapped read-only and scanned in place. Fields are
+// (ptr, len) slices into the mapping; nothing is copied except the name.
+// ─────────────────────────────────────────────────────────────────────────────
+typedef struct {
+    const char *p;
+    size_t len;
+} Field;
+
+static int csv_fail(CsvError *err, size_t line, const char *fmt, const char *arg) {
+    if (err) {
+        err->line = line;
+        snprintf(err->msg, sizeof(err->msg), fmt, arg);
+    }
+    return -1;
+}
+
+static Field trim(Field f) {
+    while (f.len && (*f.p == ' ' || *f.p == '\t')) { f.p++; f.len--; }
+    while (f.len && (f.p[f.len - 1] == ' ' || f.p[f.len - 1] == '\t' || f.p[f.len - 1] == '\r')) f.len--;
+    return f;
+}
+
+// "bad priority 'x7'": names the field and quotes (a prefix of) its text
+static int csv_fail_field(CsvError *err, size_t line, const char *what, Field f) {
+    f = trim(f);
+    if (err) {
+        err->line = line;
+        snprintf(err->msg, sizeof(err->msg), "%s '%.*s'", what, (int)(f.len > 40 ? 40 : f.len), f.p);
+    }
+    return -1;
+}
+
+static int field_eq(Field f, const char *s) {
+    size_t n = strlen(s);
+    return f.len == n && memcmp(f.p, s, n) == 0;
+}
+
+// Decimal integer with optional sign; the whole field must be consumed.
+static int scan_long(Field f, long min, long max, long *out) {
+    f = trim(f);
+    size_t i = 0;
+    int neg = 0;
+    if (i < f.len && (f.p[i] == '-' || f.p[i] == '+')) neg = f.p[i++] == '-';
+    if (i == f.len) return -1;
+    unsigned long v = 0;
+    for (; i < f.len; ++i) {
+        unsigned d = (unsigned)(f.p[i] - '0');
+        if (d > 9) return -1;
+        v = v * 10 + d;
+        if (v > (unsigned long)max + (neg ? 1UL : 0UL)) return -1;
+    }
+    long r = neg ? -(long)v : (long)v;
+    if (r < min || r > max) return -1;
+    *out = r;
+    return 0;
+}
+
+static int scan_service(Field f, ServiceType *out) {
+    f = trim(f);
+    if (field_eq(f, "Consultation")) *out = SERVICE_CONSULTATION;
+    else if (field_eq(f, "Lab Test")) *out = SERVICE_LAB_TEST;
+    else if (field_eq(f, "Treatment")) *out = SERVICE_TREATMENT;
+    else {
+        long v;
+        if (scan_long(f, 0, 2, &v) != 0) return -1;
+        *out = (ServiceType)v;
+    }
+    return 0;
+}
 
-    size_t cap = 16;
-    Patient *items = (Patient *)malloc(sizeof(Patient) * cap);
-    if (!items) { fclose(f); return -1; }
-    size_t count = 0;
-
-    char line[512];
-    while (fgets(line, sizeof(line), f)) {
-        if (line[0] == '#' || strlen(line) < 3) continue;
-        // id,name,service,priority,required_ms,arrival_ms
-        char *tok;
-        int id, priority; unsigned req_ms, arr_ms; char name[MAX_NAME_LEN]; char svc[64];
-        // Use a copy since strtok mutates
-        char buf[512];
-        strncpy(buf, line, sizeof(buf)); buf[sizeof(buf)-1] = '\0';
-        tok = strtok(buf, ",\n"); if (!tok) continue; id = atoi(tok);
-        tok = strtok(NULL, ",\n"); if (!tok) continue; snprintf(name, MAX_NAME_LEN, "%s", tok);
-        tok = strtok(NULL, ",\n"); if (!tok) continue; snprintf(svc, sizeof(svc), "%s", tok);
-        tok = strtok(NULL, ",\n"); if (!tok) continue; priority = atoi(tok);
-        tok = strtok(NULL, ",\n"); if (!tok) continue; req_ms = (unsigned)atoi(tok);
-        tok = strtok(NULL, ",\n"); if (!tok) continue; arr_ms = (unsigned)atoi(tok);
-
-        if (count == cap) {
-            cap *= 2;
-            Patient *ni = (Patient *)realloc(items, sizeof(Patient) * cap);
-            if (!ni) { free(items); fclose(f); return -1; }
-            items = ni;
+// Split [p, end) at the next `sep` (or end).
+static Field next_field(const char **p, const char *end, char sep) {
+    const char *start = *p;
+    const char *hit = (const char *)memchr(start, sep, (size_t)(end - start));
+    Field f = { start, (size_t)((hit ? hit : end) - start) };
+    *p = hit ? hit + 1 : end;
+    return f;
+}
+
+// "Consultation:300>Lab Test:500>Treatment+Doctor:200" (services by name or
+// number; "+Type" adds a resource held for the stage). Returns the number of
+// steps, or -1 if malformed.
+static int scan_pathway(Field f, PathStep *out) {
+    const char *p = f.p, *end = f.p + f.len;
+    int n = 0;
+    while (p < end) {
+        if (n == MAX_PATH_STEPS) return -1;
+        Field step = next_field(&p, end, '>');
+        const char *colon = NULL;
+        for (size_t i = step.len; i-- > 0;)
+            if (step.p[i] == ':') { colon = step.p + i; break; }
+        if (!colon) return -1;
+        const char *q = step.p;
+        Field svc = next_field(&q, colon, '+');
+        ServiceType st;
+        if (scan_service(svc, &st) != 0) return -1;
+        out[n].service = (unsigned char)st;
+        out[n].extra = 0;
+        while (q < colon) {
+            Field res = trim(next_field(&q, colon, '+'));
+            int t = 0;
+            while (t < RESOURCE_TYPE_COUNT && !field_eq(res, resource_names[t])) ++t;
+            if (t == RESOURCE_TYPE_COUNT) return -1;
+            out[n].extra |= (unsigned char)(1u << t);
         }
-        Patient *p = &items[count++];
-        p->id = id > 0 ? id : (int)count;
-        snprintf(p->name, MAX_NAME_LEN, "%s", name);
-        p->service = parse_service(svc);
-        p->priority = priority;
-        p->required_time_ms = req_ms;
-        p->arrival_ms = arr_ms;
+        long dur;
+        Field d = { colon + 1, (size_t)(step.p + step.len - colon - 1) };
+        if (scan_long(d, 0, 0x7fffffff, &dur) != 0) return -1;
+        out[n].duration_ms = (unsigned)dur;
+        n++;
     }
-    fclose(f);
+    return n > 0 ? n : -1;
+}
+
+static int skip_line(const char *p, const char *eol) {
+    while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    return p == eol || *p == '#';
+}
+
+// id,name,service,priority,required_ms,arrival_ms[,pathway]
+// Returns -1 with the reason in *err when the line is malformed.
+static int parse_record(const char *p, const char *eol, size_t line, Patient *out, CsvError *err) {
+    Field f[7];
+    int nf = 0;
+    for (;;) {
+        if (nf == 7) return csv_fail(err, line, "%s", "too many fields (expected 6 or 7)");
+        const char *comma = (const char *)memchr(p, ',', (size_t)(eol - p));
+        f[nf++] = (Field){ p, (size_t)((comma ? comma : eol) - p) };
+        if (!comma) break;
+        p = comma + 1;
+    }
+    if (nf < 6) return csv_fail(err, line, "%s", "too few fields (expected 6 or 7)");
+
+    long id, priority, req, arr;
+    ServiceType svc;
+    if (scan_long(f[0], -2147483647L, 2147483647L, &id) != 0) return csv_fail_field(err, line, "bad id", f[0]);
+    Field name = trim(f[1]);
+    if (name.len == 0) return csv_fail(err, line, "%s", "empty name");
+    if (scan_service(f[2], &svc) != 0) svc = SERVICE_CONSULTATION;   // unknown: Consultation, as always
+    if (scan_long(f[3], -2147483647L, 2147483647L, &priority) != 0) return csv_fail_field(err, line, "bad priority", f[3]);
+    if (scan_long(f[4], 0, 0xffffffffL, &req) != 0) return csv_fail_field(err, line, "bad required_ms", f[4]);
+    if (scan_long(f[5], 0, 0xffffffffL, &arr) != 0) return csv_fail_field(err, line, "bad arrival_ms", f[5]);
+
+    memset(out, 0, sizeof(*out));
+    out->id = (int)id;
+    size_t nlen = name.len < MAX_NAME_LEN - 1 ? name.len : MAX_NAME_LEN - 1;
+    memcpy(out->name, name.p, nlen);
+    out->name[nlen] = '\0';
+    out->service = svc;
+    out->priority = (int)priority;
+    out->required_time_ms = (unsigned)req;
+    out->arrival_ms = (unsigned)arr;
+    out->path_len = 0;
+    if (nf == 7 && trim(f[6]).len > 0) {
+        PathStep steps[MAX_PATH_STEPS];
+        int nsteps = scan_pathway(trim(f[6]), steps);
+        if (nsteps < 0) return csv_fail_field(err, line, "bad pathway", f[6]);
+        if (patient_set_path(out, steps, nsteps) != 0)
+            return csv_fail_field(err, line, "pathway total exceeds required_ms range", f[6]);
+    }
+    return 0;
+}
+
+// Count a skipped line; the first one also fills line and msg
+static void csv_note_skip(CsvError *err, const CsvError *why) {
+    if (!err) return;
+    if (err->skipped == 0) {
+        err->line = why->line;
+        memcpy(err->msg, why->msg, sizeof(err->msg));
+    }
+    if (err->skipped < CSV_SKIPPED_LINES) err->skipped_line[err->skipped] = why->line;
+    err->skipped++;
+}
+
+void csv_format_skips(const CsvError *err, char *buf, size_t size) {
+    buf[0] = '\0';
+    if (!err || err->skipped == 0 || size == 0) return;
+    size_t off = 0;
+    int w = snprintf(buf, size, "skipped %zu malformed line%s (", err->skipped, err->skipped == 1 ? "" : "s");
+    size_t shown = err->skipped < CSV_SKIPPED_LINES ? err->skipped : CSV_SKIPPED_LINES;
+    for (size_t i = 0; i < shown && w >= 0 && off + (size_t)w < size; ++i) {
+        off += (size_t)w;
+        w = snprintf(buf + off, size - off, "%s%zu", i ? ", " : "", err->skipped_line[i]);
+    }
+    if (w >= 0 && off + (size_t)w < size) {
+        off += (size_t)w;
+        snprintf(buf + off, size - off, "%s); line %zu: %s", err->skipped > shown ? ", ..." : "",
+                 err->line, err->msg);
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Parallel load: the mapping is cut into chunks at newline boundaries. Pass 1
+// counts candidate records and lines per chunk; prefix sums then give every
+// chunk its slice of the (once-allocated) patient array and its first line
+// number, so pass 2 parses each chunk straight into place. Malformed lines
+// leave a gap at the end of their chunk's slice; the slices are then moved
+// down in file order, and the per-chunk skip reports merged the same way.
+// ─────────────────────────────────────────────────────────────────────────────
+#define CSV_MIN_CHUNK (1u << 20)   // below this per thread, fewer threads
+#define CSV_MAX_THREADS 64
+
+typedef struct {
+    const char *begin, *end;
+    size_t records, lines;      // pass 1: candidate (non-comment) lines
+    size_t first_record;        // prefix sums
+    size_t first_line;
+    Patient *items;             // pass 2 output base (shared array)
+    size_t parsed;              // pass 2: records kept
+    int implicit_ids;           // some kept record has id <= 0
+    CsvError skips;
+} CsvChunk;
+
+static void *chunk_count(void *arg) {
+    CsvChunk *c = (CsvChunk *)arg;
+    for (const char *p = c->begin; p < c->end;) {
+        const char *eol = (const char *)memchr(p, '\n', (size_t)(c->end - p));
+        if (!eol) eol = c->end;
+        c->lines++;
+        if (!skip_line(p, eol)) c->records++;
+        p = eol + 1;
+    }
+    return NULL;
+}
+
+static void *chunk_parse(void *arg) {
+    CsvChunk *c = (CsvChunk *)arg;
+    Patient *out = c->items + c->first_record;
+    size_t line = c->first_line;
+    for (const char *p = c->begin; p < c->end; ++line) {
+        const char *eol = (const char *)memchr(p, '\n', (size_t)(c->end - p));
+        if (!eol) eol = c->end;
+        if (!skip_line(p, eol)) {
+            CsvError why;
+            if (parse_record(p, eol, line, &out[c->parsed], &why) == 0) {
+                if (out[c->parsed].id <= 0) c->implicit_ids = 1;
+                c->parsed++;
+            } else {
+                csv_note_skip(&c->skips, &why);
+            }
+        }
+        p = eol + 1;
+    }
+    return NULL;
+}
+
+// Close the gaps left by skipped lines, number records without an id by
+// their final position, and merge the skip reports in file order.
+static size_t chunks_compact(CsvChunk *chunks, int n, Patient *items, CsvError *err) {
+    size_t kept = 0;
+    for (int i = 0; i < n; ++i) {
+        CsvChunk *c = &chunks[i];
+        if (kept != c->first_record && c->parsed > 0)
+            memmove(&items[kept], &items[c->first_record], sizeof(Patient) * c->parsed);
+        if (c->implicit_ids)
+            for (size_t k = kept; k < kept + c->parsed; ++k)
+                if (items[k].id <= 0) items[k].id = (int)k + 1;
+        kept += c->parsed;
+        if (!err || c->skips.skipped == 0) continue;
+        if (err->skipped == 0) {
+            err->line = c->skips.line;
+            memcpy(err->msg, c->skips.msg, sizeof(err->msg));
+        }
+        size_t have = c->skips.skipped < CSV_SKIPPED_LINES ? c->skips.skipped : CSV_SKIPPED_LINES;
+        for (size_t j = 0; j < have && err->skipped + j < CSV_SKIPPED_LINES; ++j)
+            err->skipped_line[err->skipped + j] = c->skips.skipped_line[j];
+        err->skipped += c->skips.skipped;
+    }
+    return kept;
+}
+
+// Run fn over every chunk, one thread each (the first on the caller).
+static void run_chunks(CsvChunk *chunks, int n, void *(*fn)(void *)) {
+    pthread_t th[CSV_MAX_THREADS];
+    int started[CSV_MAX_THREADS] = {0};
+    for (int i = 1; i < n; ++i)
+        started[i] = pthread_create(&th[i], NULL, fn, &chunks[i]) == 0;
+    fn(&chunks[0]);
+    for (int i = 1; i < n; ++i) {
+        if (started[i]) pthread_join(th[i], NULL);
+        else fn(&chunks[i]);
+    }
+}
+
+int load_patients_csv_mt(const char *path, PatientList *out_list, CsvError *err, int threads) {
+    if (err) memset(err, 0, sizeof(*err));
+    if (!path || !out_list) return csv_fail(err, 0, "%s", "invalid arguments");
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return csv_fail(err, 0, "%s", strerror(errno));
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) { close(fd); return csv_fail(err, 0, "%s", strerror(errno)); }
+
+    size_t size = (size_t)sb.st_size;
+    const char *data = NULL;
+    if (size > 0) {
+        void *m = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) { close(fd); return csv_fail(err, 0, "%s", strerror(errno)); }
+        data = (const char *)m;
+        madvise(m, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if ((size_t)threads > size / CSV_MIN_CHUNK) threads = (int)(size / CSV_MIN_CHUNK);
+    if (threads > CSV_MAX_THREADS) threads = CSV_MAX_THREADS;
+    if (threads < 1) threads = 1;
+
+    // Cut at newlines: each chunk ends just past a '\n' (or at the file end)
+    CsvChunk chunks[CSV_MAX_THREADS];
+    memset(chunks, 0, sizeof(chunks));
+    int n = 0;
+    const char *p = data, *end = data + size;
+    for (int i = 0; i < threads && p < end; ++i) {
+        const char *cut = i == threads - 1 ? end : data + size / (size_t)threads * (size_t)(i + 1);
+        if (cut < p) cut = p;
+        if (cut < end) {
+            const char *nl = (const char *)memchr(cut, '\n', (size_t)(end - cut));
+            cut = nl ? nl + 1 : end;
+        }
+        chunks[n].begin = p;
+        chunks[n].end = cut;
+        n++;
+        p = cut;
+    }
+
+    // Pass 1: exact record count, so the array is allocated once
+    if (n > 0) run_chunks(chunks, n, chunk_count);
+    size_t records = 0, lines = 0;
+    for (int i = 0; i < n; ++i) {
+        chunks[i].first_record = records;
+        chunks[i].first_line = lines + 1;
+        records += chunks[i].records;
+        lines += chunks[i].lines;
+    }
+
+    // Pages are first touched by the thread that parses into them
+    Patient *items = (Patient *)malloc(sizeof(Patient) * (records ? records : 1));
+    if (!items) {
+        if (data) munmap((void *)data, size);
+        return csv_fail(err, 0, "%s", "out of memory");
+    }
+
+    // Pass 2: parse in place, then close the gaps left by malformed lines
+    for (int i = 0; i < n; ++i) chunks[i].items = items;
+    if (n > 0) run_chunks(chunks, n, chunk_parse);
+    if (data) munmap((void *)data, size);
 
     out_list->items = items;
-    out_list->count = count;
+    out_list->count = chunks_compact(chunks, n, items, err);
+    return 0;
+}
+
+int load_patients_csv_ex(const char *path, PatientList *out_list, CsvError *err) {
+    return load_patients_csv_mt(path, out_list, err, 0);
+}
+
+int load_patients_csv(const char *path, PatientList *out_list) {
+    return load_patients_csv_ex(path, out_list, NULL);
+}
+
+int csv_reader_open(CsvReader *r, const char *path) {
+    memset(r, 0, sizeof(*r));
+    if (strcmp(path, "-") == 0) {
+        r->fp = stdin;
+        return 0;
+    }
+    r->fp = fopen(path, "r");
+    if (!r->fp) return -1;
+    r->owns_fp = 1;
     return 0;
 }
 
+int csv_reader_next(CsvReader *r, Patient *out, CsvError *err) {
+    ssize_t len;
+    while ((len = getline(&r->line, &r->cap, r->fp)) >= 0) {
+        r->line_no++;
+        const char *eol = r->line + len;
+        if (eol > r->line && eol[-1] == '\n') eol--;
+        if (skip_line(r->line, eol)) continue;
+        CsvError why;
+        if (parse_record(r->line, eol, r->line_no, out, &why) == 0) return 1;
+        csv_note_skip(&r->skips, &why);
+    }
+    if (ferror(r->fp)) return csv_fail(err, 0, "%s", strerror(errno));
+    return 0;
+}
+
+void csv_reader_close(CsvReader *r) {
+    if (r->owns_fp && r->fp) fclose(r->fp);
+    free(r->line);
+    memset(r, 0, sizeof(*r));
+}
+
 int save_patients_csv(const char *path, const PatientList *list) {
     if (!path || !list) return -1;
     FILE *f = fopen(path, "w");
     if (!f) return -1;
-    fprintf(f, "# id,name,service,priority,required_ms,arrival_ms\n");
+    fprintf(f, "# id,name,service,priority,required_ms,arrival_ms[,pathway]\n");
     for (size_t i = 0; i < list->count; ++i) {
         const Patient *p = &list->items[i];
-        fprintf(f, "%d,%s,%s,%d,%u,%u\n",
+        fprintf(f, "%d,%s,%s,%d,%u,%u",
                 p->id, p->name, service_name_storage(p->service), p->priority,
                 p->required_time_ms, p->arrival_ms);
+        if (p->path_len > 0) {
+            char pathway[256];
+            format_pathway(p, pathway, sizeof(pathway));
+            fprintf(f, ",%s", pathway);
+        }
+        fputc('\n', f);
     }
     fclose(f);
     return 0;
@@ -0,0 +1,89 @@
+#include "stream.h"
+#include "dispatch.h"
+
+#include <errno.h>
+
+typedef struct {
+    FILE *out;
+    size_t in_flight;
+    size_t finished;
+    double total_wait;
+    double total_turn;
+    unsigned long long makespan;
+} StreamState;
+
+static void stream_finish(void *ctx, const DispatchJob *job, unsigned long long t) {
+    StreamState *st = (StreamState *)ctx;
+    unsigned long long turnaround = t - job->arrival_ms;
+    unsigned long long wait = turnaround - job->burst_ms;
+    st->in_flight--;
+    st->finished++;
+    st->total_wait += (double)wait;
+    st->total_turn += (double)turnaround;
+    if (t > st->makespan) st->makespan = t;
+    if (st->out) fprintf(st->out, "%d,%u,%llu,%llu,%llu\n", job->id, job->arrival_ms, t, wait, turnaround);
+}
+
+int stream_run(const char *path, const StreamConfig *cfg, StreamResult *res, CsvError *err) {
+    memset(res, 0, sizeof(*res));
+    if (err) memset(err, 0, sizeof(*err));
+    StreamState st = { .out = cfg->out };
+    DispatchHooks hooks = { .on_finish = stream_finish, .ctx = &st };
+    Dispatcher d;
+    if (dispatcher_init(&d, cfg->alg, &hooks) != 0) {
+        if (err) { err->line = 0; snprintf(err->msg, sizeof(err->msg), "algorithm not supported in streaming mode"); }
+        return -1;
+    }
+    CsvReader r;
+    if (csv_reader_open(&r, path) != 0) {
+        if (err) { err->line = 0; snprintf(err->msg, sizeof(err->msg), "%s", strerror(errno)); }
+        dispatcher_destroy(&d);
+        return -1;
+    }
+    if (st.out) fprintf(st.out, "id,arrival_ms,finish_ms,wait_ms,turnaround_ms\n");
+
+    Patient p;
+    int rc, seq = 0;
+    unsigned last_arrival = 0;
+    while ((rc = csv_reader_next(&r, &p, err)) == 1) {
+        if (p.arrival_ms < last_arrival) {
+            if (err) {
+                err->line = r.line_no;
+                snprintf(err->msg, sizeof(err->msg), "arrival_ms %u before previous %u (input must be sorted by arrival)",
+                         p.arrival_ms, last_arrival);
+            }
+            rc = -1;
+            break;
+        }
+        last_arrival = p.arrival_ms;
+        DispatchJob job = {
+            .idx = seq++,
+            .id = p.id,
+            .arrival_ms = p.arrival_ms,
+            .burst_ms = p.required_time_ms,
+            .remaining_ms = p.required_time_ms,
+            .priority = p.priority
+        };
+        // Runs everything due before this arrival, then queues it
+        if (dispatcher_arrive(&d, &job) != 0) {
+            if (err) { err->line = r.line_no; snprintf(err->msg, sizeof(err->msg), "out of memory"); }
+            rc = -1;
+            break;
+        }
+        if (++st.in_flight > res->peak_in_flight) res->peak_in_flight = st.in_flight;
+    }
+    if (rc == 0) {
+        dispatcher_drain(&d);
+        if (err) *err = r.skips;
+    }
+
+    csv_reader_close(&r);
+    dispatcher_destroy(&d);
+    res->patients = st.finished;
+    res->makespan_ms = st.makespan;
+    if (st.finished) {
+        res->avg_wait_ms = st.total_wait / (double)st.finished;
+        res->avg_turnaround_ms = st.total_turn / (double)st.finished;
+    }
+    return rc == 0 ? 0 : -1;
+}
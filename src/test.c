@@ -0,0 +1,435 @@
+// Test harness: checks the engines against slow reference implementations
+// and the resource pool's grant order. Prints one line per test and exits
+// with status 1 if any fails.
+// Usage: bin/test
+#include "common.h"
+#include "patient.h"
+#include "scheduler.h"
+#include "resources.h"
+#include "storage.h"
+#include "schedcache.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// Tests return NULL on success, else what went wrong (often formatted here)
+static char fail_buf[256];
+
+static const char *failf(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(fail_buf, sizeof(fail_buf), fmt, ap);
+    va_end(ap);
+    return fail_buf;
+}
+
+// xorshift64: fixed seeds so a failure reproduces
+static uint64_t rng_state = 88172645463325252ULL;
+
+static unsigned rnd(unsigned bound) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (unsigned)(rng_state % bound);
+}
+
+static void random_patient(Patient *p, int id, unsigned long long burst_base) {
+    memset(p, 0, sizeof(*p));
+    p->id = id;
+    snprintf(p->name, MAX_NAME_LEN, "P%d", id);
+    p->priority = 1 + (int)rnd(5);
+    p->service = (ServiceType)rnd(SERVICE_TYPE_COUNT);
+    p->required_time_ms = (unsigned)(burst_base + 1 + rnd(rnd(2) ? 50 : 500));
+    p->arrival_ms = rnd(rnd(2) ? 100 : 3000);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Round Robin: closed-form engine vs a slice-by-slice simulation
+// ─────────────────────────────────────────────────────────────────────────────
+// The reference runs one quantum at a time: patients queue in arrival order
+// (ties by index), and arrivals during a slice queue ahead of the patient
+// that slice preempts.
+static void rr_reference(const PatientList *list, unsigned quantum_ms, unsigned long long *finish) {
+    size_t n = list->count;
+    int *by_arrival = (int *)malloc(sizeof(int) * n);
+    unsigned *remaining = (unsigned *)malloc(sizeof(unsigned) * n);
+    int *queue = (int *)malloc(sizeof(int) * n);
+    for (size_t i = 0; i < n; ++i) {
+        int x = (int)i;
+        size_t j = i;
+        while (j > 0 && list->items[by_arrival[j - 1]].arrival_ms > list->items[x].arrival_ms) {
+            by_arrival[j] = by_arrival[j - 1];
+            j--;
+        }
+        by_arrival[j] = x;
+        remaining[i] = list->items[i].required_time_ms;
+    }
+    size_t head = 0, tail = 0, queued = 0, next = 0, done = 0;
+    unsigned long long time = 0;
+    while (done < n) {
+        while (next < n && list->items[by_arrival[next]].arrival_ms <= time) {
+            queue[tail] = by_arrival[next++];
+            tail = (tail + 1) % n;
+            queued++;
+        }
+        if (queued == 0) {
+            time = list->items[by_arrival[next]].arrival_ms;
+            continue;
+        }
+        int p = queue[head];
+        head = (head + 1) % n;
+        queued--;
+        unsigned slice = remaining[p] > quantum_ms ? quantum_ms : remaining[p];
+        time += slice;
+        remaining[p] -= slice;
+        while (next < n && list->items[by_arrival[next]].arrival_ms <= time) {
+            queue[tail] = by_arrival[next++];
+            tail = (tail + 1) % n;
+            queued++;
+        }
+        if (remaining[p] > 0) {
+            queue[tail] = p;
+            tail = (tail + 1) % n;
+            queued++;
+        } else {
+            finish[p] = time;
+            done++;
+        }
+    }
+    free(by_arrival);
+    free(remaining);
+    free(queue);
+}
+
+static const char *test_rr_closed_form(void) {
+    enum { CASES = 5000, MAX_N = 24 };
+    Patient items[MAX_N];
+    unsigned long long finish[MAX_N];
+    for (int c = 0; c < CASES; ++c) {
+        PatientList list = { items, 1 + rnd(MAX_N) };
+        // Alternate crowded arrivals (long queues) with sparse ones (idle gaps)
+        unsigned spread = 1 + rnd(c % 2 ? 60 : 5000);
+        for (size_t i = 0; i < list.count; ++i) {
+            memset(&items[i], 0, sizeof(Patient));
+            items[i].id = (int)i + 1;
+            items[i].priority = 1;
+            items[i].required_time_ms = rnd(3) ? rnd(12) : rnd(400);
+            items[i].arrival_ms = rnd(spread);
+        }
+        unsigned quantum = 1 + rnd(5);
+        rr_reference(&list, quantum, finish);
+        unsigned long long total = 0, max_turn = 0;
+        for (size_t i = 0; i < list.count; ++i) {
+            unsigned long long turn = finish[i] - items[i].arrival_ms;
+            total += turn;
+            if (turn > max_turn) max_turn = turn;
+        }
+
+        int *order = schedule_order(&list, ALG_RR, quantum);
+        if (!order) return "schedule_order failed";
+        ScheduleMetrics m = compute_metrics(&list, order, ALG_RR, quantum);
+        free(order);
+        double got = m.avg_turnaround_ms * (double)list.count;
+        if (got - (double)total > 1e-6 || (double)total - got > 1e-6 || m.turnaround.max != max_turn)
+            return failf("case %d (n=%zu, q=%u): turnaround total %.0f max %llu, expected %llu max %llu",
+                         c, list.count, quantum, got, (unsigned long long)m.turnaround.max, total, max_turn);
+    }
+    return NULL;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Schedule cache: patched entries vs a full recompute after every edit
+// ─────────────────────────────────────────────────────────────────────────────
+// burst_base pushes the schedules past 2^32 ms when it is large
+static const char *cache_trial(unsigned long long burst_base) {
+    enum { TRIALS = 40, EDITS = 60, CAP = 256 };
+    Patient items[CAP];
+    for (int trial = 0; trial < TRIALS; ++trial) {
+        PatientList list = { items, rnd(40) };
+        int next_id = 1;
+        for (size_t i = 0; i < list.count; ++i) random_patient(&items[i], next_id++, burst_base);
+        ScheduleCache cache;
+        schedule_cache_init(&cache, 3);
+        const char *fail = NULL;
+        for (int e = 0; e < EDITS && !fail; ++e) {
+            unsigned op = rnd(4);
+            if ((op == 0 || list.count == 0) && list.count < CAP) {
+                random_patient(&items[list.count++], next_id++, burst_base);
+                schedule_cache_added(&cache, &list);
+            } else if (op == 1 && list.count > 0) {
+                size_t i = rnd((unsigned)list.count);
+                Patient before = items[i];
+                random_patient(&items[i], before.id, burst_base);
+                if (rnd(3) == 0) items[i].arrival_ms = before.arrival_ms;
+                schedule_cache_changed(&cache, &list, i, &before);
+            } else if (op == 2 && list.count > 0) {
+                size_t i = rnd((unsigned)list.count);
+                Patient before = items[i];
+                memmove(&items[i], &items[i + 1], sizeof(Patient) * (list.count - i - 1));
+                list.count--;
+                schedule_cache_removed(&cache, &list, i, &before);
+            } else {
+                schedule_cache_refresh_all(&cache, &list);
+            }
+            for (int a = 0; a < ALG_COUNT && !fail; ++a) {
+                int *order = schedule_order(&list, (Algorithm)a, 3);
+                ScheduleMetrics want = compute_metrics(&list, order, (Algorithm)a, 3);
+                const int *got_order = schedule_cache_order(&cache, &list, (Algorithm)a);
+                const ScheduleMetrics *got = schedule_cache_metrics(&cache, &list, (Algorithm)a);
+                if (!order || !got_order || !got)
+                    fail = "out of memory";
+                else if (memcmp(order, got_order, sizeof(int) * list.count) != 0)
+                    fail = failf("trial %d edit %d: %s order differs", trial, e, alg_name((Algorithm)a));
+                else if (memcmp(&want, got, sizeof(want)) != 0)
+                    fail = failf("trial %d edit %d: %s metrics differ (avg wait %.2f, expected %.2f)",
+                                 trial, e, alg_name((Algorithm)a), got->avg_wait_ms, want.avg_wait_ms);
+                free(order);
+            }
+        }
+        schedule_cache_free(&cache);
+        if (fail) return fail;
+    }
+    return NULL;
+}
+
+static const char *test_schedule_cache(void) {
+    const char *fail = cache_trial(0);
+    return fail ? fail : cache_trial(1000000000ULL);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// CSV loader: skipped lines, implicit ids and the service fallback
+// ─────────────────────────────────────────────────────────────────────────────
+// Large enough that four threads get four chunks (chunks are at least 1 MiB)
+#define LOADER_LINES 120000
+
+typedef struct {
+    size_t count;                // records kept
+    int *ids;                    // id of each kept record
+    size_t skipped;
+    size_t skipped_line[CSV_SKIPPED_LINES];
+    size_t fallback;             // kept index of the "Xray" record
+} LoaderExpect;
+
+static int write_loader_csv(const char *path, LoaderExpect *want) {
+    static const char *services[3] = { "Consultation", "Lab Test", "Treatment" };
+    memset(want, 0, sizeof(*want));
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    want->ids = (int *)malloc(sizeof(int) * LOADER_LINES);
+    if (!want->ids) { fclose(f); return -1; }
+    fprintf(f, "# id,name,service,priority,required_ms,arrival_ms\n");
+    size_t line = 1;
+    for (int i = 0; i < LOADER_LINES; ++i) {
+        ++line;
+        if (i % 4999 == 17) {
+            // Malformed: a bad priority, or a record cut short
+            if (i % 2) fprintf(f, "%d,Bad,Lab Test,x7,40,6\n", i + 1);
+            else fprintf(f, "%d,Short,Treatment,3\n", i + 1);
+            if (want->skipped < CSV_SKIPPED_LINES) want->skipped_line[want->skipped] = line;
+            want->skipped++;
+            continue;
+        }
+        int id = i % 1000 == 3 ? 0 : i + 1;   // id 0: numbered by position
+        const char *svc = services[i % 3];
+        if (i == 70001) {
+            svc = "Xray";
+            want->fallback = want->count;
+        }
+        fprintf(f, "%d,N%d,%s,%d,%d,%d\n", id, i, svc, 1 + i % 5, 1 + i % 900, i);
+        want->ids[want->count] = id > 0 ? id : (int)want->count + 1;
+        want->count++;
+    }
+    return fclose(f);
+}
+
+static const char *check_skips(const char *who, const CsvError *err, const LoaderExpect *want) {
+    if (err->skipped != want->skipped)
+        return failf("%s: %zu lines skipped, expected %zu", who, err->skipped, want->skipped);
+    for (size_t k = 0; k < CSV_SKIPPED_LINES && k < want->skipped; ++k)
+        if (err->skipped_line[k] != want->skipped_line[k])
+            return failf("%s: skipped line #%zu is %zu, expected %zu", who, k, err->skipped_line[k], want->skipped_line[k]);
+    if (err->line != want->skipped_line[0])
+        return failf("%s: first skip reported at line %zu, expected %zu", who, err->line, want->skipped_line[0]);
+    return NULL;
+}
+
+static const char *check_load(const char *path, const LoaderExpect *want, int threads) {
+    PatientList list;
+    CsvError err;
+    if (load_patients_csv_mt(path, &list, &err, threads) != 0)
+        return failf("%d threads: load failed at line %zu: %s", threads, err.line, err.msg);
+    char who[32];
+    snprintf(who, sizeof(who), "%d threads", threads);
+    const char *fail = check_skips(who, &err, want);
+    if (!fail && list.count != want->count)
+        fail = failf("%s: %zu records, expected %zu", who, list.count, want->count);
+    for (size_t i = 0; !fail && i < list.count; ++i)
+        if (list.items[i].id != want->ids[i])
+            fail = failf("%s: record %zu has id %d, expected %d", who, i, list.items[i].id, want->ids[i]);
+    if (!fail && list.items[want->fallback].service != SERVICE_CONSULTATION)
+        fail = failf("%s: unknown service did not fall back to Consultation", who);
+    free_patients(&list);
+    return fail;
+}
+
+static const char *test_loader(void) {
+    char path[] = "/tmp/hospital_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) return "mkstemp failed";
+    close(fd);
+    LoaderExpect want;
+    const char *fail = write_loader_csv(path, &want) != 0 ? "cannot write test CSV" : NULL;
+    if (!fail) fail = check_load(path, &want, 1);
+    if (!fail) fail = check_load(path, &want, 4);
+    if (!fail) {
+        // The streaming reader reports the same lines
+        CsvReader r;
+        Patient p;
+        size_t records = 0;
+        int rc = -1;
+        if (csv_reader_open(&r, path) == 0) {
+            while ((rc = csv_reader_next(&r, &p, NULL)) == 1) records++;
+            if (rc == 0) fail = check_skips("reader", &r.skips, &want);
+            csv_reader_close(&r);
+        }
+        if (rc != 0) fail = "reader failed";
+        else if (!fail && records != want.count) fail = failf("reader: %zu records, expected %zu", records, want.count);
+    }
+    free(want.ids);
+    unlink(path);
+    return fail;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Gang grants: backfilling, aging and order
+// ─────────────────────────────────────────────────────────────────────────────
+// On a pool of 2 doctors, 1 machine and 1 room: with the room held, a
+// room+doctor gang request waits. Later doctor-only requests must be
+// backfilled around it until it has aged. After that one doctor is reserved
+// for it, but the other doctor must stay grantable. Releasing the room must
+// then serve the gang request ahead of the doctor request queued behind it.
+typedef struct {
+    ResourcePool *rp;
+    ResourceMask mask;
+    uint64_t rank;
+    _Atomic int granted;
+    _Atomic int release;
+    _Atomic uint64_t order;      // grant sequence number
+    _Atomic uint64_t *seq;
+} GangProbe;
+
+static void *gang_probe(void *arg) {
+    GangProbe *p = (GangProbe *)arg;
+    ResourceGrant g;
+    if (resources_acquire_set(p->rp, p->mask, p->rank, &g) != 0) return NULL;
+    atomic_store(&p->order, atomic_fetch_add(p->seq, 1));
+    atomic_store(&p->granted, 1);
+    while (!atomic_load(&p->release)) ms_sleep(1);
+    resources_release(p->rp, &g, 0, 0);
+    return NULL;
+}
+
+// 1 once *flag is set, 0 if it is still clear after timeout_ms
+static int wait_flag(_Atomic int *flag, unsigned timeout_ms) {
+    for (unsigned t = 0; t < timeout_ms; ++t) {
+        if (atomic_load(flag)) return 1;
+        ms_sleep(1);
+    }
+    return atomic_load(flag) != 0;
+}
+
+static size_t ready_waiters(ResourcePool *rp) {
+    pthread_mutex_lock(&rp->lock);
+    size_t n = rp->ready_count;
+    pthread_mutex_unlock(&rp->lock);
+    return n;
+}
+
+static int start_probe(GangProbe *p, pthread_t *th, ResourcePool *rp, ResourceMask mask, uint64_t rank,
+                       _Atomic uint64_t *seq) {
+    p->rp = rp;
+    p->mask = mask;
+    p->rank = rank;
+    atomic_init(&p->granted, 0);
+    atomic_init(&p->release, 0);
+    atomic_init(&p->order, 0);
+    p->seq = seq;
+    return pthread_create(th, NULL, gang_probe, p);
+}
+
+static void finish_probe(GangProbe *p, pthread_t th) {
+    atomic_store(&p->release, 1);
+    pthread_join(th, NULL);
+}
+
+// On failure threads may still be blocked; the harness exits without joining them
+static const char *gang_check_pool(ResourcePool *rp) {
+    const ResourceMask doctor = RESOURCE_MASK(RESOURCE_DOCTOR);
+    const ResourceMask room = RESOURCE_MASK(RESOURCE_ROOM);
+    _Atomic uint64_t seq = 1;
+    ResourceGrant held_room;
+    if (resources_acquire(rp, RESOURCE_ROOM, 0, &held_room) != 0) return "room acquire";
+
+    static GangProbe gang, single, late;   // outlive a failed check's blocked threads
+    pthread_t gang_th, single_th, late_th;
+    if (start_probe(&gang, &gang_th, rp, room | doctor, 1, &seq) != 0) return "thread create";
+    for (int t = 0; ready_waiters(rp) == 0 && t < 1000; ++t) ms_sleep(1);
+    if (ready_waiters(rp) != 1) return "gang request did not queue";
+
+    // Backfilled around the waiting gang request until it has aged
+    for (int i = 0; i <= RESOURCE_AGING_LIMIT; ++i) {
+        if (start_probe(&single, &single_th, rp, doctor, 2 + (uint64_t)i, &seq) != 0) return "thread create";
+        if (!wait_flag(&single.granted, 1000)) return "doctor request not backfilled around the gang request";
+        if (i < RESOURCE_AGING_LIMIT) finish_probe(&single, single_th);
+    }
+    // Aged: one doctor is held by `single`, the other is reserved for the gang
+    if (start_probe(&late, &late_th, rp, doctor, 100, &seq) != 0) return "thread create";
+    if (wait_flag(&late.granted, 50)) return "aged gang request's doctor was given away";
+    resources_release(rp, &held_room, 0, 0);
+    if (!wait_flag(&gang.granted, 1000)) return "aged gang request not served";
+    finish_probe(&single, single_th);
+    finish_probe(&gang, gang_th);
+    if (!wait_flag(&late.granted, 1000)) return "doctor request behind the gang request never served";
+    finish_probe(&late, late_th);
+    if (atomic_load(&late.order) < atomic_load(&gang.order)) return "gang request served out of order";
+    return NULL;
+}
+
+static const char *test_gang_grants(void) {
+    static ResourcePool rp;
+    if (resources_init(&rp, 2, 1, 1) != 0) return "resources_init failed";
+    const char *fail = gang_check_pool(&rp);
+    if (!fail) resources_destroy(&rp);
+    return fail;
+}
+
+int main(void) {
+    static const struct {
+        const char *name;
+        const char *(*run)(void);
+    } tests[] = {
+        { "rr_closed_form", test_rr_closed_form },
+        { "schedule_cache", test_schedule_cache },
+        { "loader", test_loader },
+        { "gang_grants", test_gang_grants },
+    };
+    int failed = 0;
+    for (size_t t = 0; t < sizeof(tests) / sizeof(tests[0]); ++t) {
+        const char *fail = tests[t].run();
+        if (fail) {
+            printf("FAIL %s: %s\n", tests[t].name, fail);
+            failed++;
+        } else {
+            printf("ok   %s\n", tests[t].name);
+        }
+        fflush(stdout);
+    }
+    if (failed) {
+        printf("%d test(s) failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -1,50 +1,241 @@
+#include "common.h"
 #include "thread_worker.h"
+#include "logfmt.h"
+#include "trace.h"
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 
-static const char *service_name(ServiceType s) {
-    switch (s) {
-        case SERVICE_CONSULTATION: return "Consultation";
-        case SERVICE_LAB_TEST: return "LabTest";
-        case SERVICE_TREATMENT: return "Treatment";
-        default: return "Unknown";
+void log_patient_event(LogRing *log, LogEvent event, const Patient *p, ServiceType stage) {
+    if (log) log_ring_push(log, event, p->id, stage);
+}
+
+void log_patient_event_at(LogRing *log, LogEvent event, const Patient *p, ServiceType stage,
+                          uint64_t ts_ns) {
+    if (log) log_ring_push_at(log, event, p->id, stage, ts_ns);
+}
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+// serve_patient, calling first_done(ctx) once the first stage's units are
+// released (or could not be acquired)
+static void serve_pathway(const Patient *p, size_t rank, ResourcePool *rp, LogRing *log,
+                          void (*first_done)(void *), void *ctx) {
+    PathStep steps[MAX_PATH_STEPS];
+    int nsteps = patient_path(p, steps);
+    uint64_t t_start = now_ms();
+
+    log_patient_event(log, LOG_EVENT_START, p, (ServiceType)steps[0].service);
+
+    // Walk the pathway; each stage queues on its own resource, keeping the
+    // patient's schedule rank so later stages are granted in the same order
+    for (int s = 0; s < nsteps; ++s) {
+        ResourceType rt = resource_type_for_service((ServiceType)steps[s].service);
+        ResourceGrant grant;
+        if (rp->live) live_stats_queued(rp->live, rt);
+        // The stage's own resource plus any it needs alongside, all at once
+        uint64_t t_trace = trace_begin();
+        if (resources_acquire_set(rp, RESOURCE_MASK(rt) | steps[s].extra, rank, &grant) != 0) {
+            perror("resources_acquire");
+            // Leave the queue unserved and close the visit where it stopped
+            if (rp->live) live_stats_abandoned(rp->live, rt);
+            if (s == 0 && first_done) first_done(ctx);
+            log_patient_event(log, LOG_EVENT_FINISH, p, (ServiceType)steps[s].service);
+            return;
+        }
+        trace_end("acquire", t_trace, "patient", p->id);
+        if (rp->live) live_stats_acquired(rp->live, rt, grant.waited_ms);
+        t_trace = trace_begin();
+        ms_sleep(steps[s].duration_ms);
+        trace_end(log_service_name(steps[s].service), t_trace, "patient", p->id);
+        // Busy time equals the stage duration for non-preemptive service
+        resources_release(rp, &grant, p->id, steps[s].duration_ms);
+        if (s == 0 && first_done) first_done(ctx);
+        if (rp->live) {
+            if (s + 1 < nsteps) live_stats_stage_done(rp->live, rt, steps[s].duration_ms);
+            else live_stats_released(rp->live, rt, steps[s].duration_ms, now_ms() - t_start);
+        }
     }
+
+    log_patient_event(log, LOG_EVENT_FINISH, p, (ServiceType)steps[nsteps - 1].service);
+}
+
+void serve_patient(const Patient *p, size_t rank, ResourcePool *rp, LogRing *log) {
+    serve_pathway(p, rank, rp, log, NULL, NULL);
 }
 
 void *patient_thread(void *arg) {
     WorkerArgs *wa = (WorkerArgs *)arg;
-    Patient p = wa->patient;
-    sem_t *res = resource_for_service(wa->resources, p.service);
-
-    char buf[256];
-    snprintf(buf, sizeof(buf), "START id=%d name=%s service=%s\n", p.id, p.name, service_name(p.service));
-    write(wa->fifo_fd, buf, strlen(buf));
-
-    sem_wait(res);
-    ms_sleep(p.required_time_ms);
-    sem_post(res);
-
-    // Accumulate resource busy time (equals required time for non-preemptive service)
-    pthread_mutex_lock(&wa->resources->log_mutex);
-    switch (p.service) {
-        case SERVICE_CONSULTATION:
-            wa->resources->busy_doctors_ms += p.required_time_ms;
-            break;
-        case SERVICE_LAB_TEST:
-            wa->resources->busy_machines_ms += p.required_time_ms;
-            break;
-        case SERVICE_TREATMENT:
-            wa->resources->busy_rooms_ms += p.required_time_ms;
-            break;
-        default:
-            break;
-    }
-    pthread_mutex_unlock(&wa->resources->log_mutex);
+    serve_patient(&wa->patient, wa->rank, wa->resources, wa->log);
+    return NULL;
+}
 
-    snprintf(buf, sizeof(buf), "FINISH id=%d name=%s service=%s\n", p.id, p.name, service_name(p.service));
-    write(wa->fifo_fd, buf, strlen(buf));
+// ─────────────────────────────────────────────────────────────────────────────
+// Bounded worker pool
+// ─────────────────────────────────────────────────────────────────────────────
+// Patients are queued by the resource type of their first stage, each queue
+// in scheduled order. A worker claims the lowest-ranked head among the types
+// that have fewer patients still in their first stage than units, so a run of
+// doctor patients cannot tie up every worker while machines and rooms idle.
+typedef struct {
+    const PatientList *list;
+    const int *order;
+    ResourcePool *resources;
+    LogRing *log;
+    pthread_mutex_t lock;                    // protects everything below
+    pthread_cond_t slot_free;                // a first stage finished
+    size_t *queue[RESOURCE_TYPE_COUNT];      // positions in order[], by first-stage type
+    size_t queue_len[RESOURCE_TYPE_COUNT];
+    size_t head[RESOURCE_TYPE_COUNT];        // next position to hand out per type
+    int pending[RESOURCE_TYPE_COUNT];        // claimed patients still in their first stage
+    int limit[RESOURCE_TYPE_COUNT];          // units of each type
+} WorkerPool;
+
+typedef struct {
+    WorkerPool *pool;
+    ResourceType type;
+} PoolClaim;
+
+static ResourceType first_stage_type(const Patient *p) {
+    PathStep steps[MAX_PATH_STEPS];
+    patient_path(p, steps);
+    return resource_type_for_service((ServiceType)steps[0].service);
+}
+
+static void claim_first_done(void *arg) {
+    PoolClaim *c = (PoolClaim *)arg;
+    pthread_mutex_lock(&c->pool->lock);
+    c->pool->pending[c->type]--;
+    pthread_cond_broadcast(&c->pool->slot_free);
+    pthread_mutex_unlock(&c->pool->lock);
+}
 
+// Next position to serve, or (size_t)-1 when every queue is drained
+static size_t pool_claim(WorkerPool *pool, ResourceType *type) {
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        int best = -1, left = 0;
+        for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) {
+            if (pool->head[t] == pool->queue_len[t]) continue;
+            left = 1;
+            if (pool->pending[t] >= pool->limit[t]) continue;
+            if (best < 0 || pool->queue[t][pool->head[t]] < pool->queue[best][pool->head[best]]) best = t;
+        }
+        if (best >= 0) {
+            size_t k = pool->queue[best][pool->head[best]++];
+            pool->pending[best]++;
+            pthread_mutex_unlock(&pool->lock);
+            *type = (ResourceType)best;
+            return k;
+        }
+        if (!left) break;
+        pthread_cond_wait(&pool->slot_free, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return (size_t)-1;
+}
+
+static void *pool_worker(void *arg) {
+    WorkerPool *pool = (WorkerPool *)arg;
+    trace_thread_name("worker");
+    PoolClaim claim = { .pool = pool };
+    size_t k;
+    while ((k = pool_claim(pool, &claim.type)) != (size_t)-1)
+        serve_pathway(&pool->list->items[pool->order[k]], k, pool->resources, pool->log,
+                      claim_first_done, &claim);
     return NULL;
 }
+
+static void pool_free_queues(WorkerPool *pool) {
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) free(pool->queue[t]);
+}
+
+// Split order[] by first-stage type, keeping scheduled order within each queue
+static int pool_build_queues(WorkerPool *pool) {
+    const PatientList *list = pool->list;
+    for (size_t k = 0; k < list->count; ++k)
+        pool->queue_len[first_stage_type(&list->items[pool->order[k]])]++;
+    for (int t = 0; t < RESOURCE_TYPE_COUNT; ++t) {
+        pool->queue[t] = (size_t *)malloc(sizeof(size_t) * (pool->queue_len[t] ? pool->queue_len[t] : 1));
+        if (!pool->queue[t]) {
+            pool_free_queues(pool);
+            return -1;
+        }
+        pool->queue_len[t] = 0;
+        pool->limit[t] = resources_units(pool->resources, (ResourceType)t);
+        if (pool->limit[t] < 1) pool->limit[t] = 1;
+    }
+    for (size_t k = 0; k < list->count; ++k) {
+        ResourceType t = first_stage_type(&list->items[pool->order[k]]);
+        pool->queue[t][pool->queue_len[t]++] = k;
+    }
+    return 0;
+}
+
+int default_worker_count(const ResourcePool *rp) {
+    int total = rp->num_doctors + rp->num_machines + rp->num_rooms;
+    return total > 0 ? total : 1;
+}
+
+int run_worker_pool(const PatientList *list, const int *order, ResourcePool *rp,
+                    LogRing *log, int workers) {
+    if (list->count == 0) return 0;
+    if (workers <= 0) {
+        // A worker waiting for a later stage holds no unit, so scale with the
+        // longest pathway to keep every stage's units fed
+        int longest = 1;
+        for (size_t i = 0; i < list->count; ++i)
+            if (list->items[i].path_len > longest) longest = list->items[i].path_len;
+        workers = default_worker_count(rp) * longest;
+    }
+    if ((size_t)workers > list->count) workers = (int)list->count;
+
+    WorkerPool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.list = list;
+    pool.order = order;
+    pool.resources = rp;
+    pool.log = log;
+    if (pool_build_queues(&pool) != 0) return -1;
+    if (pthread_mutex_init(&pool.lock, NULL) != 0) {
+        pool_free_queues(&pool);
+        return -1;
+    }
+    if (pthread_cond_init(&pool.slot_free, NULL) != 0) {
+        pthread_mutex_destroy(&pool.lock);
+        pool_free_queues(&pool);
+        return -1;
+    }
+
+    pthread_t *threads = (pthread_t *)calloc((size_t)workers, sizeof(pthread_t));
+    if (!threads) {
+        pthread_cond_destroy(&pool.slot_free);
+        pthread_mutex_destroy(&pool.lock);
+        pool_free_queues(&pool);
+        return -1;
+    }
+    int started = 0;
+    for (int w = 0; w < workers; ++w) {
+        uint64_t t_trace = trace_begin();
+        if (pthread_create(&threads[started], NULL, pool_worker, &pool) != 0) {
+            perror("pthread_create");
+            break;
+        }
+        trace_end("thread create", t_trace, "worker", started);
+        started++;
+    }
+    uint64_t t_join = trace_begin();
+    for (int w = 0; w < started; ++w) pthread_join(threads[w], NULL);
+    trace_end("join workers", t_join, "workers", started);
+
+    free(threads);
+    pthread_cond_destroy(&pool.slot_free);
+    pthread_mutex_destroy(&pool.lock);
+    pool_free_queues(&pool);
+    return started > 0 ? 0 : -1;
+}
@@ -0,0 +1,192 @@
+#include "common.h"
+#include "trace.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+typedef struct {
+    const char *name;
+    const char *arg_name;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+    int64_t arg;
+} TraceEvent;
+
+typedef struct TraceChunk {
+    struct TraceChunk *next;
+    size_t used;
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+} TraceChunk;
+
+typedef struct TraceBuffer {
+    struct TraceBuffer *next;  // registry link
+    long tid;
+    const char *name;
+    TraceChunk *head, *tail;
+    size_t chunks;
+    uint64_t dropped;
+} TraceBuffer;
+
+int trace_enabled;
+
+static const char *g_process_name = "hospital_scheduler";
+static pthread_mutex_t g_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static TraceBuffer *g_buffers;
+static _Thread_local TraceBuffer *tls_buffer;
+
+void trace_start(const char *process_name) {
+    if (process_name) g_process_name = process_name;
+    trace_enabled = 1;
+}
+
+uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// The calling thread's buffer, registered on first use (the only locked step)
+static TraceBuffer *thread_buffer(void) {
+    if (tls_buffer) return tls_buffer;
+    TraceBuffer *b = (TraceBuffer *)calloc(1, sizeof(TraceBuffer));
+    if (!b) return NULL;
+    b->tid = (long)syscall(SYS_gettid);
+    pthread_mutex_lock(&g_registry_lock);
+    b->next = g_buffers;
+    g_buffers = b;
+    pthread_mutex_unlock(&g_registry_lock);
+    tls_buffer = b;
+    return b;
+}
+
+void trace_thread_name(const char *name) {
+    if (!trace_enabled) return;
+    TraceBuffer *b = thread_buffer();
+    if (b) b->name = name;
+}
+
+void trace_record(const char *name, uint64_t start_ns, const char *arg_name, int64_t arg) {
+    uint64_t end_ns = trace_now_ns();
+    TraceBuffer *b = thread_buffer();
+    if (!b) return;
+    TraceChunk *c = b->tail;
+    if (!c || c->used == TRACE_CHUNK_EVENTS) {
+        if (b->chunks == TRACE_MAX_CHUNKS || !(c = (TraceChunk *)malloc(sizeof(TraceChunk)))) {
+            b->dropped++;
+            return;
+        }
+        c->next = NULL;
+        c->used = 0;
+        if (b->tail) b->tail->next = c;
+        else b->head = c;
+        b->tail = c;
+        b->chunks++;
+    }
+    c->events[c->used++] = (TraceEvent){
+        .name = name, .arg_name = arg_name, .start_ns = start_ns,
+        .dur_ns = end_ns - start_ns, .arg = arg
+    };
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Export
+// ─────────────────────────────────────────────────────────────────────────────
+// Chrome wants microseconds; keep the nanoseconds as three decimals
+static void put_us(FILE *f, uint64_t ns) {
+    fprintf(f, "%llu.%03u", (unsigned long long)(ns / 1000), (unsigned)(ns % 1000));
+}
+
+// One JSON object per line, each preceded by `sep` (empty for the first line)
+static uint64_t write_events(FILE *f, const char **sep) {
+    long pid = (long)getpid();
+    uint64_t dropped = 0;
+    fprintf(f, "%s{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%ld,\"args\":{\"name\":\"%s\"}}",
+            *sep, pid, g_process_name);
+    *sep = ",\n";
+    for (TraceBuffer *b = g_buffers; b; b = b->next) {
+        if (b->name)
+            fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+                    *sep, pid, b->tid, b->name);
+        for (const TraceChunk *c = b->head; c; c = c->next) {
+            for (size_t i = 0; i < c->used; ++i) {
+                const TraceEvent *e = &c->events[i];
+                fprintf(f, "%s{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%ld,\"tid\":%ld,\"ts\":", *sep, e->name, pid, b->tid);
+                put_us(f, e->start_ns);
+                fputs(",\"dur\":", f);
+                put_us(f, e->dur_ns);
+                if (e->arg_name) fprintf(f, ",\"args\":{\"%s\":%lld}", e->arg_name, (long long)e->arg);
+                fputc('}', f);
+            }
+        }
+        dropped += b->dropped;
+    }
+    return dropped;
+}
+
+static int finish_file(FILE *f, const char *path, uint64_t dropped) {
+    int rc = ferror(f) ? -1 : 0;
+    if (fclose(f) != 0) rc = -1;
+    if (rc != 0) perror(path);
+    if (dropped > 0)
+        fprintf(stderr, "trace: %llu events dropped (buffer limit reached)\n", (unsigned long long)dropped);
+    return rc;
+}
+
+int trace_write_fragment(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    const char *sep = "";
+    uint64_t dropped = write_events(f, &sep);
+    fputc('\n', f);
+    return finish_file(f, path, dropped);
+}
+
+int trace_write_json(const char *path, const char *fragment_path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    const char *sep = "";
+    fputs("{\"traceEvents\":[\n", f);
+    uint64_t dropped = write_events(f, &sep);
+
+    FILE *frag = fragment_path ? fopen(fragment_path, "r") : NULL;
+    if (frag) {
+        char *line = NULL;
+        size_t cap = 0;
+        ssize_t n;
+        while ((n = getline(&line, &cap, frag)) > 0) {
+            while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == ',')) line[--n] = '\0';
+            if (n > 0) fprintf(f, "%s%s", sep, line);
+        }
+        free(line);
+        fclose(frag);
+    }
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+    return finish_file(f, path, dropped);
+}
+
+void trace_reset(void) {
+    pthread_mutex_lock(&g_registry_lock);
+    TraceBuffer *b = g_buffers;
+    g_buffers = NULL;
+    pthread_mutex_unlock(&g_registry_lock);
+    while (b) {
+        TraceBuffer *next = b->next;
+        TraceChunk *c = b->head;
+        while (c) {
+            TraceChunk *cn = c->next;
+            free(c);
+            c = cn;
+        }
+        free(b);
+        b = next;
+    }
+    tls_buffer = NULL;
+    trace_enabled = 0;
+}
@@ -22,10 +22,29 @@
 #include "thread_worker.h"
 #include "ipc.h"
 #include "storage.h"
+#include "dispatch.h"
+#include "schedcache.h"
+#include "logfmt.h"
+
+#define UI_MAX_UNITS_SHOWN 8   // per-unit busy columns on the results screen
 
 // ─────────────────────────────────────────────────────────────────────────────
 // UI State
 // ─────────────────────────────────────────────────────────────────────────────
+typedef struct {
+    int idx;               // patient index in list
+    unsigned long long start_ms;
+    unsigned long long end_ms;
+} Slice;
+
+// Gantt slices of one algorithm, rebuilt when its schedule version moves
+typedef struct {
+    Slice *slices;
+    size_t count;
+    uint64_t version;      // schedule_cache_version() the slices were built from
+    int built;
+} TimelineCache;
+
 typedef struct {
     Patient *items;
     size_t count;
@@ -37,13 +56,11 @@ typedef struct {
 
     Algorithm alg;
     unsigned quantum_ms;
-} UiState;
 
-typedef struct {
-    int idx;               // patient index in list
-    unsigned start_ms;
-    unsigned end_ms;
-} Slice;
+    // Orders and metrics per algorithm; every patient edit is reported to it
+    ScheduleCache sched;
+    TimelineCache timelines[ALG_COUNT];
+} UiState;
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Helper Functions
@@ -67,6 +84,18 @@ static void ui_init(UiState *st) {
     st->rooms = 4;
     st->alg = ALG_FCFS;
     st->quantum_ms = 3;
+    schedule_cache_init(&st->sched, st->quantum_ms);
+}
+
+static void ui_free(UiState *st) {
+    schedule_cache_free(&st->sched);
+    for (int a = 0; a < ALG_COUNT; ++a) free(st->timelines[a].slices);
+    free(st->items);
+}
+
+static PatientList ui_list(const UiState *st) {
+    PatientList list = { .items = st->items, .count = st->count };
+    return list;
 }
 
 static void ui_init_colors(void) {
@@ -98,7 +127,10 @@ static void add_patient(UiState *st, const char *name, int priority, ServiceType
     p->service = svc;
     p->required_time_ms = req_ms;
     p->arrival_ms = arr_ms;
+    p->path_len = 0;
     st->count++;
+    PatientList list = ui_list(st);
+    schedule_cache_added(&st->sched, &list);
 }
 
 static Patient *find_patient(UiState *st, int id, size_t *idx_out) {
@@ -114,6 +146,7 @@ static Patient *find_patient(UiState *st, int id, size_t *idx_out) {
 static int delete_patient(UiState *st, int id) {
     size_t idx;
     if (!find_patient(st, id, &idx)) return -1;
+    Patient before = st->items[idx];
     for (size_t i = idx + 1; i < st->count; ++i) st->items[i-1] = st->items[i];
     st->count--;
     if (st->count == 0) {
@@ -121,6 +154,8 @@ static int delete_patient(UiState *st, int id) {
     } else {
         st->items = (Patient *)realloc(st->items, sizeof(Patient) * st->count);
     }
+    PatientList list = ui_list(st);
+    schedule_cache_removed(&st->sched, &list, idx, &before);
     return 0;
 }
 
@@ -184,8 +219,9 @@ static ServiceType prompt_service(ServiceType def) {
 }
 
 static Algorithm prompt_alg(Algorithm def) {
-    const char *opts[] = {"FCFS (First Come First Serve)", "SJF (Shortest Job First)", 
-                          "Priority Scheduling", "Round Robin (Preemptive)"};
+    const char *opts[ALG_COUNT] = {"FCFS (First Come First Serve)", "SJF (Shortest Job First)",
+                                   "Priority Scheduling", "Round Robin (Preemptive)",
+                                   "SRTF (Shortest Remaining Time First)", "Priority Scheduling (Preemptive)"};
     int choice = (int)def;
     while (1) {
         clear();
@@ -195,7 +231,7 @@ static Algorithm prompt_alg(Algorithm def) {
         mvprintw(3, 2, "+----------------------------------------------+");
         if (has_colors()) attroff(COLOR_PAIR(1) | A_BOLD);
         
-        for (int i = 0; i < 4; ++i) {
+        for (int i = 0; i < ALG_COUNT; ++i) {
             if (i == choice) attron(A_REVERSE | A_BOLD);
             mvprintw(5 + i, 4, " %d. %s ", i+1, opts[i]);
             if (i == choice) attroff(A_REVERSE | A_BOLD);
@@ -203,7 +239,7 @@ static Algorithm prompt_alg(Algorithm def) {
         mvprintw(LINES-2, 2, "Up/Down: Navigate | Enter: Select | q: Cancel");
         int ch = getch();
         if (ch == KEY_UP) { if (choice > 0) choice--; }
-        else if (ch == KEY_DOWN) { if (choice < 3) choice++; }
+        else if (ch == KEY_DOWN) { if (choice < ALG_COUNT - 1) choice++; }
         else if (ch == '\n') break;
         else if (ch == 'q') return def;
     }
@@ -219,7 +255,7 @@ static void draw_resource_usage_pattern(const PatientList *list, const Slice *sl
         return;
     }
     
-    unsigned max_end = 0;
+    unsigned long long max_end = 0;
     for (size_t i = 0; i < count; ++i)
         if (slices[i].end_ms > max_end) max_end = slices[i].end_ms;
     
@@ -232,7 +268,7 @@ static void draw_resource_usage_pattern(const PatientList *list, const Slice *sl
     int color_pairs[3] = {6, 7, 8}; // Consultation=green, Lab=yellow, Treatment=red
     
     if (has_colors()) attron(COLOR_PAIR(1) | A_BOLD);
-    mvprintw(start_row, 2, "RESOURCE USAGE PATTERN (0 - %u ms)", max_end);
+    mvprintw(start_row, 2, "RESOURCE USAGE PATTERN (0 - %llu ms)", max_end);
     if (has_colors()) attroff(COLOR_PAIR(1) | A_BOLD);
     mvhline(start_row + 1, 2, '-', COLS - 4);
     
@@ -292,8 +328,8 @@ static void draw_resource_usage_pattern(const PatientList *list, const Slice *sl
     // Time axis
     int axis_row = base_row + 6;
     mvprintw(axis_row, left, "0");
-    mvprintw(axis_row, left + width/2 - 2, "%u", max_end/2);
-    mvprintw(axis_row, left + width - 6, "%u ms", max_end);
+    mvprintw(axis_row, left + width/2 - 2, "%llu", max_end/2);
+    mvprintw(axis_row, left + width - 6, "%llu ms", max_end);
     
     // Legend
     int legend_row = axis_row + 1;
@@ -312,27 +348,97 @@ static void draw_resource_usage_pattern(const PatientList *list, const Slice *sl
     mvprintw(legend_row, 34, "=Room  (X=first letter of patient name)");
 }
 
+// One lane per resource unit, from the intervals the pool recorded
+static void draw_unit_lanes(const PatientList *list, const ResourcePool *rp, int start_row) {
+    static const char *unit_names[RESOURCE_TYPE_COUNT] = { "Doctor", "Machine", "Room" };
+    int color_pairs[RESOURCE_TYPE_COUNT] = {6, 7, 8};
+
+    uint64_t max_end = 0;
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r)
+        for (int u = 0; u < resources_units(rp, (ResourceType)r); ++u) {
+            const UnitTimeline *tl = resources_unit_timeline(rp, (ResourceType)r, u);
+            for (size_t i = 0; i < tl->count; ++i)
+                if (tl->items[i].end_ms > max_end) max_end = tl->items[i].end_ms;
+        }
+    if (max_end == 0) {
+        mvprintw(start_row, 2, "No per-unit activity recorded.");
+        return;
+    }
+
+    int left = 16, right = COLS - 4;
+    int width = right - left;
+    if (width < 20) width = 20;
+
+    int row = start_row;
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r) {
+        for (int u = 0; u < resources_units(rp, (ResourceType)r) && row < LINES - 5; ++u, ++row) {
+            if (has_colors()) attron(COLOR_PAIR(2) | A_BOLD);
+            mvprintw(row, 2, "%s #%d", unit_names[r], u + 1);
+            if (has_colors()) attroff(COLOR_PAIR(2) | A_BOLD);
+            mvaddch(row, left - 1, '[');
+            for (int c = left; c < right; ++c) mvaddch(row, c, '.');
+            mvaddch(row, right, ']');
+
+            const UnitTimeline *tl = resources_unit_timeline(rp, (ResourceType)r, u);
+            for (size_t i = 0; i < tl->count; ++i) {
+                const UnitInterval *iv = &tl->items[i];
+                char ch = '#';
+                for (size_t k = 0; k < list->count; ++k)
+                    if (list->items[k].id == iv->patient_id) { ch = list->items[k].name[0]; break; }
+                int col_start = left + (int)((double)iv->start_ms / max_end * width);
+                int col_end = left + (int)((double)iv->end_ms / max_end * width);
+                if (col_end <= col_start) col_end = col_start + 1;
+                if (has_colors()) attron(COLOR_PAIR(color_pairs[r]) | A_BOLD);
+                for (int c = col_start; c < col_end && c < right; ++c) mvaddch(row, c, ch);
+                if (has_colors()) attroff(COLOR_PAIR(color_pairs[r]) | A_BOLD);
+            }
+        }
+    }
+
+    mvprintw(row + 1, left, "0");
+    mvprintw(row + 1, left + width/2 - 2, "%llu", (unsigned long long)max_end / 2);
+    mvprintw(row + 1, left + width - 6, "%llu ms", (unsigned long long)max_end);
+    mvprintw(row + 2, 2, "Each lane is one unit; letters are the first letter of the patient served.");
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Gantt Chart / Timeline Building
 // ─────────────────────────────────────────────────────────────────────────────
-static const PatientList *g_ui_cmp_ctx = NULL;
-
-static int cmp_arrival(const void *a, const void *b) {
-    int ia = *(const int *)a, ib = *(const int *)b;
-    unsigned aa = g_ui_cmp_ctx->items[ia].arrival_ms;
-    unsigned ab = g_ui_cmp_ctx->items[ib].arrival_ms;
-    if (aa < ab) return -1;
-    if (aa > ab) return 1;
-    return ia - ib;
+typedef struct {
+    Slice *slices;
+    size_t count;
+    size_t cap;
+} SliceSink;
+
+static void collect_slice(void *ctx, const DispatchJob *job, unsigned long long start, unsigned long long end) {
+    SliceSink *sink = (SliceSink *)ctx;
+    if (sink->count < sink->cap)
+        sink->slices[sink->count++] = (Slice){ .idx = job->idx, .start_ms = start, .end_ms = end };
 }
 
-static Slice *build_timeline(const PatientList *list, Algorithm alg, unsigned quantum_ms, size_t *out_count) {
+// Orders and non-preemptive start times come from the schedule cache
+static Slice *build_timeline(ScheduleCache *sc, const PatientList *list, Algorithm alg, unsigned quantum_ms,
+                             size_t *out_count) {
     size_t n = list->count;
     if (n == 0) { *out_count = 0; return NULL; }
-    int *order = schedule_order(list, alg, quantum_ms);
+    if (dispatch_is_preemptive(alg)) {
+        // Each arrival preempts at most once, so 2n slices always suffice
+        SliceSink sink = { .slices = (Slice *)malloc(sizeof(Slice) * 2 * n), .count = 0, .cap = 2 * n };
+        DispatchHooks hooks = { .on_start = NULL, .on_slice = collect_slice, .on_finish = NULL, .ctx = &sink };
+        if (sink.slices) dispatch_run_list(list, alg, &hooks);
+        *out_count = sink.count;
+        return sink.slices;
+    }
+    const int *order = schedule_cache_order(sc, list, alg);
+    const unsigned long long *starts = schedule_cache_starts(sc, list, alg);
     size_t cap = alg == ALG_RR ? (size_t)(10 * n) : n;
     Slice *slices = (Slice *)malloc(sizeof(Slice) * cap);
     size_t count = 0;
+    if (!order || (alg != ALG_RR && !starts) || !slices) {
+        free(slices);
+        *out_count = 0;
+        return NULL;
+    }
 
     if (alg == ALG_RR) {
         unsigned *remaining = (unsigned *)malloc(sizeof(unsigned) * n);
@@ -341,15 +447,12 @@ static Slice *build_timeline(const PatientList *list, Algorithm alg, unsigned qu
             remaining[i] = list->items[i].required_time_ms; 
             arrival[i] = list->items[i].arrival_ms; 
         }
-        int *arrival_order = (int *)malloc(sizeof(int) * n);
-        for (size_t i = 0; i < n; ++i) arrival_order[i] = order[i];
-        g_ui_cmp_ctx = list;
-        qsort(arrival_order, n, sizeof(int), cmp_arrival);
-        g_ui_cmp_ctx = NULL;
+        // schedule_order() already returns RR patients in arrival order
+        const int *arrival_order = order;
 
         int *queue = (int *)malloc(sizeof(int) * n);
         size_t head = 0, tail = 0, qcount = 0, completed = 0, next_arrival = 0;
-        unsigned time = 0;
+        unsigned long long time = 0;
         if (next_arrival < n) time = arrival[arrival_order[next_arrival]];
 
         while (completed < n && count < cap) {
@@ -373,7 +476,7 @@ static Slice *build_timeline(const PatientList *list, Algorithm alg, unsigned qu
             qcount--;
             if (remaining[pid] == 0) continue;
             unsigned slice = remaining[pid] > quantum_ms ? quantum_ms : remaining[pid];
-            unsigned start = time; 
+            unsigned long long start = time; 
             time += slice; 
             remaining[pid] -= slice;
             slices[count++] = (Slice){ .idx = pid, .start_ms = start, .end_ms = time };
@@ -394,30 +497,47 @@ static Slice *build_timeline(const PatientList *list, Algorithm alg, unsigned qu
                 completed++; 
             }
         }
-        free(remaining); free(arrival); free(arrival_order); free(queue);
+        free(remaining); free(arrival); free(queue);
     } else {
-        unsigned time = 0;
         for (size_t k = 0; k < n && count < cap; ++k) {
-            int i = order[k]; 
-            Patient p = list->items[i];
-            if (p.arrival_ms > time) time = p.arrival_ms;
-            unsigned start = time; 
-            unsigned end = start + p.required_time_ms; 
-            time = end;
-            slices[count++] = (Slice){ .idx = i, .start_ms = start, .end_ms = end };
+            int i = order[k];
+            slices[count++] = (Slice){ .idx = i, .start_ms = starts[k], .end_ms = starts[k] + list->items[i].required_time_ms };
         }
     }
-    free(order);
     *out_count = count;
     return slices;
 }
 
+// Slices for alg, rebuilt only after an edit (or quantum change) moved its schedule
+static const Slice *cached_timeline(UiState *st, Algorithm alg, size_t *out_count) {
+    TimelineCache *tc = &st->timelines[alg];
+    if (!tc->built || tc->version != schedule_cache_version(&st->sched, alg)) {
+        PatientList list = ui_list(st);
+        free(tc->slices);
+        tc->slices = build_timeline(&st->sched, &list, alg, st->quantum_ms, &tc->count);
+        tc->version = schedule_cache_version(&st->sched, alg);
+        tc->built = tc->slices != NULL;
+    }
+    *out_count = tc->count;
+    return tc->slices;
+}
+
+// Every algorithm's metrics; only entries invalidated since the last call are computed
+static void cached_all_metrics(UiState *st, ScheduleMetrics out[ALG_COUNT]) {
+    PatientList list = ui_list(st);
+    schedule_cache_refresh_all(&st->sched, &list);
+    for (int a = 0; a < ALG_COUNT; ++a) {
+        const ScheduleMetrics *m = schedule_cache_metrics(&st->sched, &list, (Algorithm)a);
+        out[a] = m ? *m : (ScheduleMetrics){0};
+    }
+}
+
 static void draw_timeline(const PatientList *list, const Slice *slices, size_t count, int start_row) {
     if (count == 0) { 
         mvprintw(start_row, 2, "No timeline to display."); 
         return; 
     }
-    unsigned max_end = 0; 
+    unsigned long long max_end = 0; 
     for (size_t i = 0; i < count; ++i) 
         if (slices[i].end_ms > max_end) max_end = slices[i].end_ms;
     
@@ -426,7 +546,7 @@ static void draw_timeline(const PatientList *list, const Slice *slices, size_t c
     if (width < 10) width = 10;
     
     if (has_colors()) attron(COLOR_PAIR(1));
-    mvprintw(start_row, 2, "GANTT CHART (Timeline: 0 - %u ms)", max_end);
+    mvprintw(start_row, 2, "GANTT CHART (Timeline: 0 - %llu ms)", max_end);
     if (has_colors()) attroff(COLOR_PAIR(1));
     mvhline(start_row + 1, 2, '-', COLS-4);
     
@@ -450,8 +570,8 @@ static void draw_timeline(const PatientList *list, const Slice *slices, size_t c
     }
     int axis_row = base_row + (int)list->count + 1;
     mvprintw(axis_row, left, "0");
-    mvprintw(axis_row, left + width/2 - 2, "%u", max_end/2);
-    mvprintw(axis_row, left + width - 4, "%u ms", max_end);
+    mvprintw(axis_row, left + width/2 - 2, "%llu", max_end/2);
+    mvprintw(axis_row, left + width - 4, "%llu ms", max_end);
     
     // Legend
     mvprintw(axis_row + 1, 2, "Legend: ");
@@ -493,9 +613,12 @@ static void view_patients(UiState *st) {
         if (p->priority <= 2) color = 8; // High priority - red
         else if (p->priority == 3) color = 7; // Medium - yellow
         
+        char svc[32];
+        if (p->path_len > 1) snprintf(svc, sizeof(svc), "%s+%d", service_name(p->service), p->path_len - 1);
+        else snprintf(svc, sizeof(svc), "%s", service_name(p->service));
         if (has_colors()) attron(COLOR_PAIR(color));
         mvprintw(row++, 2, "%-4d %-18s %-14s %-10d %-10u %-12u",
-                 p->id, p->name, service_name(p->service), p->priority,
+                 p->id, p->name, svc, p->priority,
                  p->required_time_ms, p->arrival_ms);
         if (has_colors()) attroff(COLOR_PAIR(color));
     }
@@ -516,21 +639,41 @@ static void view_logs(void) {
     mvprintw(3, 2, "+------------------------------------------------------------------------------+");
     if (has_colors()) attroff(COLOR_PAIR(1) | A_BOLD);
     
-    FILE *f = fopen("logs/log.txt", "r");
+    FILE *f = fopen(LOG_BIN_PATH, "rb");
     if (!f) {
         mvprintw(5, 2, "No log file found yet. Run the scheduler first.");
         mvprintw(LINES-2, 2, "Press any key to return...");
         getch();
         return;
     }
-    char line[256];
+    // The file holds every run; show the events of the latest one
+    LogRecord recs[1024];
+    size_t n, total = 0, last_run = 0;
+    int runs = 0;
+    while ((n = fread(recs, sizeof(LogRecord), 1024, f)) > 0) {
+        for (size_t i = 0; i < n; ++i)
+            if (recs[i].event == LOG_EVENT_RUN) { last_run = total + i; runs++; }
+        total += n;
+    }
+    LogDecoder dec = { .run = runs > 0 ? runs - 1 : 0 };
+    char line[160];
     int row = 5;
-    while (fgets(line, sizeof(line), f) && row < LINES-3) {
-        // Remove newline
-        line[strcspn(line, "\n")] = '\0';
-        mvprintw(row++, 2, "%.76s", line);
+    size_t shown = 0;
+    if (fseek(f, (long)(last_run * sizeof(LogRecord)), SEEK_SET) == 0) {
+        LogRecord r;
+        while (row < LINES-4 && fread(&r, sizeof(r), 1, f) == 1) {
+            int header = log_format_record(&dec, &r, 0, line, sizeof(line));
+            if (header && has_colors()) attron(COLOR_PAIR(2));
+            mvprintw(row++, 2, "%.76s", line);
+            if (header && has_colors()) attroff(COLOR_PAIR(2));
+            shown++;
+        }
     }
     fclose(f);
+    if (shown == 0) mvprintw(row++, 2, "No events recorded yet. Run the scheduler first.");
+    else if (last_run + shown < total)
+        mvprintw(row++, 2, "... %zu more events; bin/logdump prints them all.", total - last_run - shown);
+    mvprintw(LINES-3, 2, "Run reports: logs/log.txt");
     mvprintw(LINES-2, 2, "Press any key to return...");
     getch();
 }
@@ -558,6 +701,8 @@ static void show_help(void) {
     mvprintw(row++, 4, "2. SJF   - Shortest Job First (non-preemptive, by burst time)");
     mvprintw(row++, 4, "3. Priority - By priority value (1=highest, 5=lowest)");
     mvprintw(row++, 4, "4. Round Robin - Preemptive with time quantum");
+    mvprintw(row++, 4, "5. SRTF  - Shortest Remaining Time First (preemptive SJF)");
+    mvprintw(row++, 4, "6. Priority (Preemptive) - Higher priority arrivals preempt");
     row++;
     
     if (has_colors()) attron(COLOR_PAIR(2));
@@ -572,7 +717,7 @@ static void show_help(void) {
     mvprintw(row++, 2, "OS CONCEPTS DEMONSTRATED:");
     if (has_colors()) attroff(COLOR_PAIR(2));
     mvprintw(row++, 4, "* Multithreading (pthreads) - Parallel patient processing");
-    mvprintw(row++, 4, "* Synchronization (Mutex/Semaphores) - Resource protection");
+    mvprintw(row++, 4, "* Synchronization (Mutex/Condvars) - Ranked resource unit grants");
     mvprintw(row++, 4, "* IPC (Pipes, Message Queues, Shared Memory) - Logger communication");
     mvprintw(row++, 4, "* Process Creation (fork/exec) - Logger process");
     mvprintw(row++, 4, "* Dynamic Memory (malloc/calloc/free) - Patient data");
@@ -595,7 +740,7 @@ static void view_gantt(UiState *st) {
     list.items = st->items; 
     list.count = st->count;
     size_t sc = 0; 
-    Slice *sl = build_timeline(&list, a, st->quantum_ms, &sc);
+    const Slice *sl = cached_timeline(st, a, &sc);
     
     clear();
     if (has_colors()) attron(COLOR_PAIR(1) | A_BOLD);
@@ -607,7 +752,6 @@ static void view_gantt(UiState *st) {
     draw_timeline(&list, sl, sc, 5);
     mvprintw(LINES-2, 2, "Press any key to return...");
     getch();
-    free(sl);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -657,6 +801,7 @@ static void run_scheduler(UiState *st) {
     if (resources_init(&resources, st->doctors, st->machines, st->rooms) != 0) {
         clear(); mvprintw(3, 2, "Failed to init resources."); getch(); return;
     }
+    resources_enable_timeline(&resources);
 
     PatientList list;
     list.items = st->items;
@@ -665,35 +810,34 @@ static void run_scheduler(UiState *st) {
     struct timespec t0, t1;
     clock_gettime(CLOCK_MONOTONIC, &t0);
 
-    int *order = schedule_order(&list, st->alg, st->quantum_ms);
-    ScheduleMetrics metrics = compute_metrics(&list, order, st->alg, st->quantum_ms);
+    const int *order = schedule_cache_order(&st->sched, &list, st->alg);
+    const ScheduleMetrics *cached = schedule_cache_metrics(&st->sched, &list, st->alg);
+    ScheduleMetrics metrics = cached ? *cached : (ScheduleMetrics){0};
 
-    if (stats) {
-        stats->avg_wait_ms = metrics.avg_wait_ms;
-        stats->avg_turnaround_ms = metrics.avg_turnaround_ms;
-        stats->completed_jobs = (int)list.count;
-    }
+    // Live stats page (counters only if shared memory is unavailable)
+    LiveStats live;
+    int live_ok = (live_stats_init(&live, stats, &metrics, (int)list.count, LIVE_STATS_PERIOD_MS) == 0);
+    if (live_ok) resources.live = &live;
+
+    int workers = default_worker_count(&resources);
+    LogRing log_ring;
+    LogTransport log_out = { .fd = fifo_fd, .shm = NULL };
+    int ring_ok = (log_ring_init(&log_ring, &log_out, LOG_RING_DEFAULT_CAP, LOG_CLOCK_MONOTONIC) == 0);
+    int pool_rc = order ? run_worker_pool(&list, order, &resources, ring_ok ? &log_ring : NULL, workers) : -1;
+
+    if (live_ok) live_stats_destroy(&live);
+    resources.live = NULL;
     if (mq != (mqd_t)-1 && stats) {
         mq_send(mq, "STATS_READY", strlen("STATS_READY"), 1);
     }
-
-    pthread_t *threads = (pthread_t *)calloc(list.count, sizeof(pthread_t));
-    WorkerArgs *args = (WorkerArgs *)calloc(list.count, sizeof(WorkerArgs));
-    for (size_t k = 0; k < list.count; ++k) {
-        int idx = order[k];
-        args[k].patient = list.items[idx];
-        args[k].resources = &resources;
-        args[k].fifo_fd = fifo_fd;
-        pthread_create(&threads[k], NULL, patient_thread, &args[k]);
-        ms_sleep(10);
-    }
-    for (size_t k = 0; k < list.count; ++k) pthread_join(threads[k], NULL);
+    if (ring_ok) log_ring_destroy(&log_ring);
 
     clock_gettime(CLOCK_MONOTONIC, &t1);
     unsigned long long elapsed_ms = (unsigned long long)((t1.tv_sec - t0.tv_sec) * 1000ULL + (t1.tv_nsec - t0.tv_nsec) / 1000000ULL);
 
-    free(order); free(threads); free(args);
-    resources_destroy(&resources);
+    ResourceTotals totals[RESOURCE_TYPE_COUNT];
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r) resources_totals(&resources, (ResourceType)r, &totals[r]);
+
     close(fifo_fd);
     if (mq != (mqd_t)-1) ipc_close_mq(mq);
     ms_sleep(100);
@@ -705,6 +849,10 @@ static void run_scheduler(UiState *st) {
     }
 
     int status = 0; waitpid(pid, &status, 0);
+    if (pool_rc != 0) {
+        resources_destroy(&resources);
+        clear(); mvprintw(3, 2, "Failed to start worker threads."); getch(); return;
+    }
 
     // Display results
     clear();
@@ -726,29 +874,55 @@ static void run_scheduler(UiState *st) {
     if (has_colors()) attroff(COLOR_PAIR(3) | A_BOLD);
     mvprintw(row++, 4, "Average Waiting Time:    %8.2f ms", metrics.avg_wait_ms);
     mvprintw(row++, 4, "Average Turnaround Time: %8.2f ms", metrics.avg_turnaround_ms);
+    mvprintw(row++, 4, "Wait p50/p95/p99/max:       %llu / %llu / %llu / %llu ms",
+             (unsigned long long)metrics.wait.p50, (unsigned long long)metrics.wait.p95,
+             (unsigned long long)metrics.wait.p99, (unsigned long long)metrics.wait.max);
+    mvprintw(row++, 4, "Turnaround p50/p95/p99/max: %llu / %llu / %llu / %llu ms",
+             (unsigned long long)metrics.turnaround.p50, (unsigned long long)metrics.turnaround.p95,
+             (unsigned long long)metrics.turnaround.p99, (unsigned long long)metrics.turnaround.max);
+    // p95/p99 wait per priority class and per service, one line each
+    mvprintw(row, 4, "Wait p95/p99 by priority:");
+    for (int c = 0, col = 30; c < METRICS_PRIORITY_CLASSES && col + 16 < COLS; ++c, col += 16)
+        mvprintw(row, col, "P%d %llu/%llu", c + 1, (unsigned long long)metrics.wait_by_priority[c].p95,
+                 (unsigned long long)metrics.wait_by_priority[c].p99);
+    row++;
+    mvprintw(row, 4, "Wait p95/p99 by service:");
+    for (int sv = 0, col = 30; sv < SERVICE_TYPE_COUNT && col + 26 < COLS; ++sv, col += 26)
+        mvprintw(row, col, "%s %llu/%llu", service_name((ServiceType)sv),
+                 (unsigned long long)metrics.wait_by_service[sv].p95, (unsigned long long)metrics.wait_by_service[sv].p99);
+    row++;
     mvprintw(row++, 4, "Total Execution Time:    %8llu ms", elapsed_ms);
     mvprintw(row++, 4, "Completed Jobs:          %8d", (int)list.count);
+    mvprintw(row++, 4, "Worker Threads:          %8d", workers);
     row++;
     
-    double util_doctors = elapsed_ms ? (double)resources.busy_doctors_ms / (elapsed_ms * resources.num_doctors) : 0.0;
-    double util_machines = elapsed_ms ? (double)resources.busy_machines_ms / (elapsed_ms * resources.num_machines) : 0.0;
-    double util_rooms = elapsed_ms ? (double)resources.busy_rooms_ms / (elapsed_ms * resources.num_rooms) : 0.0;
-    
+    static const char *type_labels[RESOURCE_TYPE_COUNT] = { "Doctors", "Machines", "Rooms" };
     if (has_colors()) attron(COLOR_PAIR(2));
     mvprintw(row++, 2, "RESOURCE UTILIZATION:");
     if (has_colors()) attroff(COLOR_PAIR(2));
-    mvprintw(row++, 4, "Doctors (%d):  %5.1f%%", resources.num_doctors, util_doctors * 100.0);
-    mvprintw(row++, 4, "Machines (%d): %5.1f%%", resources.num_machines, util_machines * 100.0);
-    mvprintw(row++, 4, "Rooms (%d):    %5.1f%%", resources.num_rooms, util_rooms * 100.0);
+    for (int r = 0; r < RESOURCE_TYPE_COUNT; ++r) {
+        const ResourceTotals *t = &totals[r];
+        double util = elapsed_ms ? (double)t->busy_ms / ((double)elapsed_ms * t->units) : 0.0;
+        double avg_wait = t->served ? (double)t->wait_ms / (double)t->served : 0.0;
+        mvprintw(row, 4, "%-8s (%d): %5.1f%%  avg wait %7.1f ms  peak %d/%d  units:",
+                 type_labels[r], t->units, util * 100.0, avg_wait, t->max_in_use, t->units);
+        int col = 4 + 58;
+        for (int u = 0; u < t->units && u < UI_MAX_UNITS_SHOWN && col + 5 < COLS; ++u, col += 5) {
+            uint64_t busy = resources_unit_busy_ms(&resources, (ResourceType)r, u);
+            double uu = elapsed_ms ? 100.0 * (double)busy / (double)elapsed_ms : 0.0;
+            mvprintw(row, col, "%4.0f%%", uu);
+        }
+        row++;
+    }
     row++;
     
-    mvprintw(row, 2, "Logs saved to: logs/log.txt");
+    mvprintw(row, 2, "Events saved to: logs/log.bin (bin/logdump)   Report: logs/log.txt");
     mvprintw(LINES-2, 2, "Press any key to view RESOURCE USAGE PATTERN...");
     getch();
     
     // Build timeline for resource usage pattern
     size_t slice_count = 0;
-    Slice *slices = build_timeline(&list, st->alg, st->quantum_ms, &slice_count);
+    const Slice *slices = cached_timeline(st, st->alg, &slice_count);
     
     // Display resource usage pattern on new screen
     clear();
@@ -762,8 +936,21 @@ static void run_scheduler(UiState *st) {
     
     draw_resource_usage_pattern(&list, slices, slice_count, 7);
     
-    if (slices) free(slices);
-    
+    mvprintw(LINES-2, 2, "Press any key to view PER-UNIT TIMELINE...");
+    getch();
+
+    // What each doctor, machine and room actually did during the run
+    clear();
+    if (has_colors()) attron(COLOR_PAIR(1) | A_BOLD);
+    mvprintw(1, 2, "+------------------------------------------------------------------------------+");
+    mvprintw(2, 2, "|                        PER-UNIT TIMELINE                                     |");
+    mvprintw(3, 2, "+------------------------------------------------------------------------------+");
+    if (has_colors()) attroff(COLOR_PAIR(1) | A_BOLD);
+
+    mvprintw(5, 2, "Algorithm: %s | Measured run: %llu ms", alg_name(st->alg), elapsed_ms);
+    draw_unit_lanes(&list, &resources, 7);
+    resources_destroy(&resources);
+
     mvprintw(LINES-2, 2, "Press any key to return...");
     getch();
 }
@@ -783,9 +970,7 @@ static void compare_algorithms(UiState *st) {
     PatientList list; 
     list.items = st->items; 
     list.count = st->count;
-    Algorithm algs[4] = { ALG_FCFS, ALG_SJF, ALG_PRIORITY, ALG_RR };
-    const char *names[4] = { "FCFS", "SJF", "Priority", "Round Robin" };
-    ScheduleMetrics mets[4];
+    ScheduleMetrics mets[ALG_COUNT];
     
     clear();
     if (has_colors()) attron(COLOR_PAIR(1) | A_BOLD);
@@ -799,24 +984,22 @@ static void compare_algorithms(UiState *st) {
     mvhline(6, 2, '-', COLS-4);
     
     if (has_colors()) attron(COLOR_PAIR(2) | A_BOLD);
-    mvprintw(8, 2, "%-16s %-20s %-22s %-10s", "Algorithm", "Avg Wait (ms)", "Avg Turnaround (ms)", "Winner");
+    mvprintw(8, 2, "%-24s %-18s %-22s %-10s", "Algorithm", "Avg Wait (ms)", "Avg Turnaround (ms)", "Winner");
     if (has_colors()) attroff(COLOR_PAIR(2) | A_BOLD);
     mvhline(9, 2, '-', COLS-4);
     
     double min_wait = 1e9, min_turn = 1e9;
     int best_wait = 0, best_turn = 0;
     
-    for (int i = 0; i < 4; ++i) {
-        int *order = schedule_order(&list, algs[i], st->quantum_ms);
-        mets[i] = compute_metrics(&list, order, algs[i], st->quantum_ms);
-        free(order);
+    cached_all_metrics(st, mets);
+    for (int i = 0; i < ALG_COUNT; ++i) {
         if (mets[i].avg_wait_ms < min_wait) { min_wait = mets[i].avg_wait_ms; best_wait = i; }
         if (mets[i].avg_turnaround_ms < min_turn) { min_turn = mets[i].avg_turnaround_ms; best_turn = i; }
     }
     
-    for (int i = 0; i < 4; ++i) {
+    for (int i = 0; i < ALG_COUNT; ++i) {
         int row = 10 + i;
-        int pair = (i == 3 ? 5 : (i == 2 ? 4 : 3));
+        int pair = (i == ALG_RR ? 5 : ((i == ALG_PRIORITY || i == ALG_PRIORITY_PREEMPTIVE) ? 4 : 3));
         if (has_colors()) attron(COLOR_PAIR(pair));
         
         char winner[32] = "";
@@ -824,16 +1007,16 @@ static void compare_algorithms(UiState *st) {
         else if (i == best_wait) snprintf(winner, sizeof(winner), "Wait");
         else if (i == best_turn) snprintf(winner, sizeof(winner), "Turn");
         
-        mvprintw(row, 2, "%-16s %-20.2f %-22.2f %-10s", names[i], mets[i].avg_wait_ms, mets[i].avg_turnaround_ms, winner);
+        mvprintw(row, 2, "%-24s %-18.2f %-22.2f %-10s", alg_name((Algorithm)i), mets[i].avg_wait_ms, mets[i].avg_turnaround_ms, winner);
         if (has_colors()) attroff(COLOR_PAIR(pair));
     }
     
-    mvhline(15, 2, '-', COLS-4);
+    mvhline(10 + ALG_COUNT, 2, '-', COLS-4);
     if (has_colors()) attron(COLOR_PAIR(3) | A_BOLD);
-    mvprintw(17, 2, "ANALYSIS:");
+    mvprintw(12 + ALG_COUNT, 2, "ANALYSIS:");
     if (has_colors()) attroff(COLOR_PAIR(3) | A_BOLD);
-    mvprintw(18, 4, "Best for Waiting Time:    %s (%.2f ms)", names[best_wait], mets[best_wait].avg_wait_ms);
-    mvprintw(19, 4, "Best for Turnaround Time: %s (%.2f ms)", names[best_turn], mets[best_turn].avg_turnaround_ms);
+    mvprintw(13 + ALG_COUNT, 4, "Best for Waiting Time:    %s (%.2f ms)", alg_name((Algorithm)best_wait), mets[best_wait].avg_wait_ms);
+    mvprintw(14 + ALG_COUNT, 4, "Best for Turnaround Time: %s (%.2f ms)", alg_name((Algorithm)best_turn), mets[best_turn].avg_turnaround_ms);
     
     mvprintw(LINES-2, 2, "Press any key to return...");
     getch();
@@ -893,28 +1076,68 @@ static void generate_report(UiState *st) {
     fprintf(f, "                           ALGORITHM COMPARISON\n");
     fprintf(f, "================================================================================\n\n");
     
-    Algorithm algs[4] = { ALG_FCFS, ALG_SJF, ALG_PRIORITY, ALG_RR };
-    const char *names[4] = { "FCFS", "SJF", "Priority", "Round Robin" };
-    ScheduleMetrics mets[4];
+    ScheduleMetrics mets[ALG_COUNT];
     
-    fprintf(f, "%-16s %-20s %-22s\n", "Algorithm", "Avg Wait (ms)", "Avg Turnaround (ms)");
+    fprintf(f, "%-24s %-18s %-22s\n", "Algorithm", "Avg Wait (ms)", "Avg Turnaround (ms)");
     fprintf(f, "--------------------------------------------------------------------------------\n");
     
     double min_wait = 1e9, min_turn = 1e9;
     int best_wait = 0, best_turn = 0;
     
-    for (int i = 0; i < 4; ++i) {
-        int *order = schedule_order(&list, algs[i], st->quantum_ms);
-        mets[i] = compute_metrics(&list, order, algs[i], st->quantum_ms);
-        free(order);
+    cached_all_metrics(st, mets);
+    for (int i = 0; i < ALG_COUNT; ++i) {
         if (mets[i].avg_wait_ms < min_wait) { min_wait = mets[i].avg_wait_ms; best_wait = i; }
         if (mets[i].avg_turnaround_ms < min_turn) { min_turn = mets[i].avg_turnaround_ms; best_turn = i; }
-        fprintf(f, "%-16s %-20.2f %-22.2f\n", names[i], mets[i].avg_wait_ms, mets[i].avg_turnaround_ms);
+        fprintf(f, "%-24s %-18.2f %-22.2f\n", alg_name((Algorithm)i), mets[i].avg_wait_ms, mets[i].avg_turnaround_ms);
     }
     
+    fprintf(f, "\nTAIL LATENCY (ms, percentiles within 12.5%%):\n");
+    fprintf(f, "%-24s %-24s %-24s\n", "Algorithm", "Wait p50/p95/p99/max", "Turnaround p50/p95/p99/max");
+    fprintf(f, "--------------------------------------------------------------------------------\n");
+    for (int i = 0; i < ALG_COUNT; ++i) {
+        char wait[32], turn[32];
+        snprintf(wait, sizeof(wait), "%llu/%llu/%llu/%llu",
+                 (unsigned long long)mets[i].wait.p50, (unsigned long long)mets[i].wait.p95,
+                 (unsigned long long)mets[i].wait.p99, (unsigned long long)mets[i].wait.max);
+        snprintf(turn, sizeof(turn), "%llu/%llu/%llu/%llu",
+                 (unsigned long long)mets[i].turnaround.p50, (unsigned long long)mets[i].turnaround.p95,
+                 (unsigned long long)mets[i].turnaround.p99, (unsigned long long)mets[i].turnaround.max);
+        fprintf(f, "%-24s %-24s %-24s\n", alg_name((Algorithm)i), wait, turn);
+    }
+
+    fprintf(f, "\nWAIT p95/p99 BY PRIORITY CLASS (ms):\n");
+    fprintf(f, "%-24s", "Algorithm");
+    for (int c = 0; c < METRICS_PRIORITY_CLASSES; ++c) fprintf(f, " P%-10d", c + 1);
+    fprintf(f, "\n--------------------------------------------------------------------------------\n");
+    for (int i = 0; i < ALG_COUNT; ++i) {
+        fprintf(f, "%-24s", alg_name((Algorithm)i));
+        for (int c = 0; c < METRICS_PRIORITY_CLASSES; ++c) {
+            char cell[24];
+            snprintf(cell, sizeof(cell), "%llu/%llu", (unsigned long long)mets[i].wait_by_priority[c].p95,
+                     (unsigned long long)mets[i].wait_by_priority[c].p99);
+            fprintf(f, " %-11s", cell);
+        }
+        fprintf(f, "\n");
+    }
+
+    fprintf(f, "\nWAIT p95/p99 BY SERVICE (ms):\n");
+    fprintf(f, "%-24s", "Algorithm");
+    for (int sv = 0; sv < SERVICE_TYPE_COUNT; ++sv) fprintf(f, " %-18s", service_name((ServiceType)sv));
+    fprintf(f, "\n--------------------------------------------------------------------------------\n");
+    for (int i = 0; i < ALG_COUNT; ++i) {
+        fprintf(f, "%-24s", alg_name((Algorithm)i));
+        for (int sv = 0; sv < SERVICE_TYPE_COUNT; ++sv) {
+            char cell[32];
+            snprintf(cell, sizeof(cell), "%llu/%llu", (unsigned long long)mets[i].wait_by_service[sv].p95,
+                     (unsigned long long)mets[i].wait_by_service[sv].p99);
+            fprintf(f, " %-18s", cell);
+        }
+        fprintf(f, "\n");
+    }
+
     fprintf(f, "\nANALYSIS:\n");
-    fprintf(f, "  Best for Waiting Time:    %s (%.2f ms)\n", names[best_wait], mets[best_wait].avg_wait_ms);
-    fprintf(f, "  Best for Turnaround Time: %s (%.2f ms)\n", names[best_turn], mets[best_turn].avg_turnaround_ms);
+    fprintf(f, "  Best for Waiting Time:    %s (%.2f ms)\n", alg_name((Algorithm)best_wait), mets[best_wait].avg_wait_ms);
+    fprintf(f, "  Best for Turnaround Time: %s (%.2f ms)\n", alg_name((Algorithm)best_turn), mets[best_turn].avg_turnaround_ms);
     fprintf(f, "\n");
     
     fprintf(f, "================================================================================\n");
@@ -922,15 +1145,17 @@ static void generate_report(UiState *st) {
     fprintf(f, "================================================================================\n\n");
     fprintf(f, "1. CPU SCHEDULING ALGORITHMS:\n");
     fprintf(f, "   - FCFS: First Come First Serve (non-preemptive, ordered by arrival)\n");
-    fprintf(f, "   - SJF: Shortest Job First (non-preemptive, ordered by burst time)\n");
+    fprintf(f, "   - SJF: Shortest Job First (non-preemptive, shortest arrived job next)\n");
     fprintf(f, "   - Priority: Jobs with higher priority (lower number) run first\n");
-    fprintf(f, "   - Round Robin: Time-sliced preemptive scheduling\n\n");
+    fprintf(f, "   - Round Robin: Time-sliced preemptive scheduling\n");
+    fprintf(f, "   - SRTF: Preemptive SJF, shortest remaining time runs\n");
+    fprintf(f, "   - Priority (Preemptive): Higher-priority arrivals preempt the running job\n\n");
     fprintf(f, "2. MULTITHREADING (pthreads):\n");
-    fprintf(f, "   - Each patient request runs as a separate thread\n");
+    fprintf(f, "   - Patient requests are served by a bounded pool of worker threads\n");
     fprintf(f, "   - Parallel execution for concurrent patient processing\n\n");
     fprintf(f, "3. SYNCHRONIZATION:\n");
-    fprintf(f, "   - Semaphores: Control access to limited resources (doctors, machines, rooms)\n");
-    fprintf(f, "   - Mutex: Protect shared data structures and logging\n\n");
+    fprintf(f, "   - Mutex + condition variables: Grant resource units in schedule order\n");
+    fprintf(f, "   - Atomics: Lock-free per-resource busy/wait accounting\n\n");
     fprintf(f, "4. INTER-PROCESS COMMUNICATION (IPC):\n");
     fprintf(f, "   - Named FIFO (Pipe): Transfer log messages to logger process\n");
     fprintf(f, "   - Message Queue: Notify logger of stats availability\n");
@@ -1035,15 +1260,35 @@ int main(void) {
                     getch(); 
                     break; 
                 }
+                Patient before = *p;
                 char name[MAX_NAME_LEN]; snprintf(name, sizeof(name), "%s", p->name);
                 prompt_str("Name", name, sizeof(name), p->name);
-                p->service = prompt_service(p->service);
+                if (p->path_len == 0) p->service = prompt_service(p->service);
                 p->priority = prompt_int("Priority (1..5)", p->priority);
                 if (p->priority < 1) p->priority = 1;
                 if (p->priority > 5) p->priority = 5;
-                p->required_time_ms = prompt_uint("Required Time (ms)", p->required_time_ms);
+                if (p->path_len == 0) {
+                    p->required_time_ms = prompt_uint("Required Time (ms)", p->required_time_ms);
+                } else {
+                    // Multi-stage visit: keep the route, edit each stage's duration
+                    PathStep steps[MAX_PATH_STEPS];
+                    int nsteps = patient_path(p, steps);
+                    for (int s = 0; s < nsteps; ++s) {
+                        char label[64];
+                        snprintf(label, sizeof(label), "Stage %d/%d %s (ms)", s + 1, nsteps,
+                                 service_name((ServiceType)steps[s].service));
+                        steps[s].duration_ms = prompt_uint(label, steps[s].duration_ms);
+                    }
+                    if (patient_set_path(p, steps, nsteps) != 0) {
+                        clear();
+                        mvprintw(3, 2, "Stage durations too large; kept the previous ones.");
+                        getch();
+                    }
+                }
                 p->arrival_ms = prompt_uint("Arrival Time (ms)", p->arrival_ms);
                 snprintf(p->name, MAX_NAME_LEN, "%s", name);
+                PatientList list = ui_list(&st);
+                schedule_cache_changed(&st.sched, &list, idx, &before);
                 break;
             }
             case '4': {
@@ -1067,7 +1312,10 @@ int main(void) {
                 break;
             }
             case '8': st.alg = prompt_alg(st.alg); break;
-            case '9': st.quantum_ms = prompt_uint("RR Quantum (ms)", st.quantum_ms); break;
+            case '9':
+                st.quantum_ms = prompt_uint("RR Quantum (ms)", st.quantum_ms);
+                schedule_cache_set_quantum(&st.sched, st.quantum_ms);
+                break;
             case 'g': {
                 int n = prompt_int("Generate how many patients?", 5);
                 if (n < 1) n = 1;
@@ -1097,7 +1345,8 @@ int main(void) {
             case 'l': {
                 char path[256]; snprintf(path, sizeof(path), "data/patients.csv");
                 PatientList loaded = {0};
-                if (load_patients_csv(path, &loaded) == 0) {
+                CsvError err;
+                if (load_patients_csv_ex(path, &loaded, &err) == 0) {
                     free(st.items);
                     st.items = loaded.items;
                     st.count = loaded.count;
@@ -1105,15 +1354,22 @@ int main(void) {
                     for (size_t i = 0; i < st.count; ++i) 
                         if (st.items[i].id > max_id) max_id = st.items[i].id;
                     st.next_id = max_id + 1;
+                    schedule_cache_invalidate(&st.sched);
                     clear(); mvprintw(3, 2, "Loaded %zu patients from %s", st.count, path);
+                    char skips[256];
+                    csv_format_skips(&err, skips, sizeof(skips));
+                    if (skips[0]) mvprintw(4, 2, "%.*s", COLS - 4, skips);
                 } else {
                     clear(); mvprintw(3, 2, "Failed to load from %s", path);
+                    if (err.line) mvprintw(4, 2, "Line %zu: %s", err.line, err.msg);
+                    else mvprintw(4, 2, "%s", err.msg);
                 }
                 mvprintw(LINES-2, 2, "Press any key to return..."); getch();
                 break;
             }
             case 'c': {
                 free(st.items); st.items = NULL; st.count = 0; st.next_id = 1;
+                schedule_cache_invalidate(&st.sched);
                 clear(); mvprintw(3, 2, "Patient list cleared.");
                 mvprintw(LINES-2, 2, "Press any key to return..."); getch();
                 break;
@@ -1132,6 +1388,6 @@ int main(void) {
     }
 
     endwin();
-    free(st.items);
+    ui_free(&st);
     return 0;
 }
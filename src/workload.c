@@ -0,0 +1,367 @@
+#include "workload.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// xoshiro256** seeded through splitmix64. Each block uses two streams, one
+// for arrival gaps and one for everything else, so the Poisson pre-pass can
+// replay the gaps alone.
+// ─────────────────────────────────────────────────────────────────────────────
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static void rng_seed(Rng *r, uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ (stream * 0xd1342543de82ef95ull);
+    for (int i = 0; i < 4; ++i) r->s[i] = splitmix64(&x);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(Rng *r) {
+    uint64_t *s = r->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// Uniform in [0, 1)
+static inline double rng_unit(Rng *r) {
+    return (double)(rng_next(r) >> 11) * 0x1.0p-53;
+}
+
+// Uniform in [0, bound), bound at most 2^32 (a whole unsigned range)
+static inline unsigned rng_below(Rng *r, uint64_t bound) {
+    return (unsigned)(((rng_next(r) >> 32) * bound) >> 32);
+}
+
+static inline double rng_exponential(Rng *r, double mean) {
+    return -mean * log1p(-rng_unit(r));
+}
+
+static inline double rng_normal(Rng *r) {
+    // Box-Muller; one draw per call keeps the stream position simple
+    double u = 1.0 - rng_unit(r), v = rng_unit(r);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Configuration
+// ─────────────────────────────────────────────────────────────────────────────
+void workload_default_config(WorkloadConfig *cfg, uint64_t seed) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->seed = seed;
+    cfg->arrival = ARRIVAL_UNIFORM;
+    cfg->window_ms = 500;
+    cfg->rate_per_s = 10.0;
+    cfg->service_time = SERVICE_TIME_UNIFORM;
+    cfg->mean_ms = 550.0;
+    cfg->sigma = 0.5;
+    cfg->min_ms = 100;
+    cfg->max_ms = 999;
+    cfg->clamp_min_ms = 100;
+    cfg->clamp_max_ms = 999;
+    for (int s = 0; s < SERVICE_TYPE_COUNT; ++s) cfg->service_weights[s] = 1.0;
+    for (int p = 0; p < WORKLOAD_PRIORITY_LEVELS; ++p) cfg->priority_weights[p] = 1.0;
+}
+
+uint64_t workload_time_seed(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t x = ((uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec) ^ ((uint64_t)getpid() << 32);
+    return splitmix64(&x);
+}
+
+// "a,b,c" into exactly n non-negative weights with a positive sum
+static int parse_weights(const char *s, double *w, int n) {
+    char *end;
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) {
+        w[i] = strtod(s, &end);
+        if (end == s || w[i] < 0.0) return -1;
+        sum += w[i];
+        if (i < n - 1) {
+            if (*end != ',') return -1;
+            s = end + 1;
+        }
+    }
+    return *end == '\0' && sum > 0.0 ? 0 : -1;
+}
+
+static int parse_arrivals(WorkloadConfig *cfg, const char *val) {
+    char *end;
+    if (strncmp(val, "poisson:", 8) == 0) {
+        double rate = strtod(val + 8, &end);
+        if (end == val + 8 || *end || !(rate > 0.0)) return -1;
+        cfg->arrival = ARRIVAL_POISSON;
+        cfg->rate_per_s = rate;
+        return 0;
+    }
+    if (strncmp(val, "uniform:", 8) == 0) {
+        unsigned long window = strtoul(val + 8, &end, 10);
+        if (end == val + 8 || *end || window == 0 || window > 0xffffffffUL) return -1;
+        cfg->arrival = ARRIVAL_UNIFORM;
+        cfg->window_ms = (unsigned)window;
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_service_time(WorkloadConfig *cfg, const char *val) {
+    char *end;
+    if (strncmp(val, "exp:", 4) == 0) {
+        double mean = strtod(val + 4, &end);
+        if (end == val + 4 || *end || !(mean > 0.0)) return -1;
+        cfg->service_time = SERVICE_TIME_EXPONENTIAL;
+        cfg->mean_ms = mean;
+        return 0;
+    }
+    if (strncmp(val, "lognormal:", 10) == 0) {
+        double mean = strtod(val + 10, &end);
+        if (end == val + 10 || *end != ',' || !(mean > 0.0)) return -1;
+        const char *p = end + 1;
+        double sigma = strtod(p, &end);
+        if (end == p || *end || !(sigma >= 0.0)) return -1;
+        cfg->service_time = SERVICE_TIME_LOGNORMAL;
+        cfg->mean_ms = mean;
+        cfg->sigma = sigma;
+        return 0;
+    }
+    if (strncmp(val, "uniform:", 8) == 0) {
+        unsigned long lo = strtoul(val + 8, &end, 10);
+        if (end == val + 8 || *end != ',') return -1;
+        const char *p = end + 1;
+        unsigned long hi = strtoul(p, &end, 10);
+        if (end == p || *end || lo > hi || hi > 0xffffffffUL) return -1;
+        cfg->service_time = SERVICE_TIME_UNIFORM;
+        cfg->min_ms = (unsigned)lo;
+        cfg->max_ms = (unsigned)hi;
+        return 0;
+    }
+    return -1;
+}
+
+int workload_parse_option(WorkloadConfig *cfg, const char *opt, const char *val) {
+    int rc;
+    const char *expect;
+    if (strcmp(opt, "--seed") == 0) {
+        char *end;
+        unsigned long long seed = strtoull(val, &end, 0);
+        rc = end == val || *end ? -1 : 0;
+        if (rc == 0) cfg->seed = seed;
+        expect = "an unsigned integer";
+    } else if (strcmp(opt, "--arrivals") == 0) {
+        rc = parse_arrivals(cfg, val);
+        expect = "poisson:<per_second> or uniform:<window_ms>";
+    } else if (strcmp(opt, "--service-time") == 0) {
+        rc = parse_service_time(cfg, val);
+        expect = "exp:<mean_ms>, lognormal:<mean_ms>,<sigma> or uniform:<min_ms>,<max_ms>";
+    } else if (strcmp(opt, "--clamp") == 0) {
+        char *end;
+        unsigned long lo = strtoul(val, &end, 10), hi = 0;
+        rc = end == val || *end != ',' ? -1 : 0;
+        if (rc == 0) {
+            const char *p = end + 1;
+            hi = strtoul(p, &end, 10);
+            rc = end == p || *end || lo > hi || hi > 0xffffffffUL ? -1 : 0;
+        }
+        if (rc == 0) { cfg->clamp_min_ms = (unsigned)lo; cfg->clamp_max_ms = (unsigned)hi; }
+        expect = "<min_ms>,<max_ms>";
+    } else if (strcmp(opt, "--service-mix") == 0) {
+        rc = parse_weights(val, cfg->service_weights, SERVICE_TYPE_COUNT);
+        expect = "3 comma-separated weights (consultation,lab,treatment)";
+    } else if (strcmp(opt, "--priority-mix") == 0) {
+        rc = parse_weights(val, cfg->priority_weights, WORKLOAD_PRIORITY_LEVELS);
+        expect = "5 comma-separated weights (priority 1..5)";
+    } else {
+        return 0;
+    }
+    if (rc != 0) {
+        fprintf(stderr, "%s: expected %s\n", opt, expect);
+        return -1;
+    }
+    return 1;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Generation. Poisson runs take two parallel passes: pass 0 sums each block's
+// gaps, a serial prefix sum turns those into block start times, and pass 1
+// replays the gaps from the start time while drawing everything else.
+// Times are accumulated in doubles and only floored to ms per patient.
+// ─────────────────────────────────────────────────────────────────────────────
+typedef struct {
+    const WorkloadConfig *cfg;
+    Patient *items;
+    size_t n;
+    size_t blocks;
+    double *block_span_ms;       // pass 0 output, then block start times
+    double service_cdf[SERVICE_TYPE_COUNT];
+    double priority_cdf[WORKLOAD_PRIORITY_LEVELS];
+    int pass;
+    int nthreads;
+} GenJob;
+
+typedef struct {
+    GenJob *job;
+    int t;
+} GenArgs;
+
+static void build_cdf(const double *w, int n, double *cdf) {
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) sum += w[i];
+    double acc = 0.0;
+    for (int i = 0; i < n; ++i) {
+        acc += w[i] / sum;
+        cdf[i] = acc;
+    }
+    cdf[n - 1] = 1.0;
+}
+
+static int pick(Rng *r, const double *cdf, int n) {
+    double u = rng_unit(r);
+    int i = 0;
+    while (i < n - 1 && u >= cdf[i]) i++;
+    return i;
+}
+
+static unsigned draw_service_ms(const WorkloadConfig *cfg, Rng *r) {
+    double ms;
+    switch (cfg->service_time) {
+        case SERVICE_TIME_EXPONENTIAL:
+            ms = rng_exponential(r, cfg->mean_ms);
+            break;
+        case SERVICE_TIME_LOGNORMAL: {
+            // mu chosen so that the distribution's mean is mean_ms
+            double mu = log(cfg->mean_ms) - cfg->sigma * cfg->sigma / 2.0;
+            ms = exp(mu + cfg->sigma * rng_normal(r));
+            break;
+        }
+        default:
+            return cfg->min_ms + rng_below(r, (uint64_t)cfg->max_ms - cfg->min_ms + 1);
+    }
+    if (ms < cfg->clamp_min_ms) return cfg->clamp_min_ms;
+    if (ms > cfg->clamp_max_ms) return cfg->clamp_max_ms;
+    return (unsigned)ms;
+}
+
+static void gen_block(GenJob *job, size_t b) {
+    const WorkloadConfig *cfg = job->cfg;
+    size_t lo = b * WORKLOAD_BLOCK;
+    size_t hi = lo + WORKLOAD_BLOCK < job->n ? lo + WORKLOAD_BLOCK : job->n;
+    double mean_gap_ms = 1000.0 / cfg->rate_per_s;
+    Rng arr, attr;
+    rng_seed(&arr, cfg->seed, 2 * (uint64_t)b);
+    rng_seed(&attr, cfg->seed, 2 * (uint64_t)b + 1);
+
+    if (job->pass == 0) {
+        double span = 0.0;
+        for (size_t i = lo; i < hi; ++i) span += rng_exponential(&arr, mean_gap_ms);
+        job->block_span_ms[b] = span;
+        return;
+    }
+
+    double t = job->block_span_ms[b];
+    for (size_t i = lo; i < hi; ++i) {
+        Patient *p = &job->items[i];
+        memset(p, 0, sizeof(*p));
+        p->id = (int)i + 1;
+        snprintf(p->name, MAX_NAME_LEN, "Patient_%02d", p->id);
+        if (cfg->arrival == ARRIVAL_POISSON) {
+            t += rng_exponential(&arr, mean_gap_ms);
+            p->arrival_ms = (unsigned)t;
+        } else {
+            p->arrival_ms = rng_below(&arr, cfg->window_ms);
+        }
+        p->priority = pick(&attr, job->priority_cdf, WORKLOAD_PRIORITY_LEVELS) + 1;
+        p->service = (ServiceType)pick(&attr, job->service_cdf, SERVICE_TYPE_COUNT);
+        p->required_time_ms = draw_service_ms(cfg, &attr);
+    }
+}
+
+static void *gen_worker(void *arg) {
+    GenArgs *ga = (GenArgs *)arg;
+    GenJob *job = ga->job;
+    for (size_t b = (size_t)ga->t; b < job->blocks; b += (size_t)job->nthreads) gen_block(job, b);
+    return NULL;
+}
+
+static void gen_pass(GenJob *job, int pass) {
+    job->pass = pass;
+    pthread_t th[64];
+    GenArgs args[64];
+    int started[64] = {0};
+    for (int t = 1; t < job->nthreads; ++t) {
+        args[t] = (GenArgs){ job, t };
+        started[t] = pthread_create(&th[t], NULL, gen_worker, &args[t]) == 0;
+    }
+    args[0] = (GenArgs){ job, 0 };
+    gen_worker(&args[0]);
+    for (int t = 1; t < job->nthreads; ++t) {
+        if (started[t]) pthread_join(th[t], NULL);
+        else gen_worker(&args[t]);   // share of a thread that failed to start
+    }
+}
+
+int generate_patients(const WorkloadConfig *cfg, size_t n, PatientList *out) {
+    out->items = NULL;
+    out->count = 0;
+    GenJob job;
+    memset(&job, 0, sizeof(job));
+    job.cfg = cfg;
+    job.n = n;
+    job.blocks = (n + WORKLOAD_BLOCK - 1) / WORKLOAD_BLOCK;
+    job.items = (Patient *)malloc(sizeof(Patient) * (n ? n : 1));
+    job.block_span_ms = (double *)calloc(job.blocks ? job.blocks : 1, sizeof(double));
+    if (!job.items || !job.block_span_ms) {
+        free(job.items); free(job.block_span_ms);
+        return -1;
+    }
+    build_cdf(cfg->service_weights, SERVICE_TYPE_COUNT, job.service_cdf);
+    build_cdf(cfg->priority_weights, WORKLOAD_PRIORITY_LEVELS, job.priority_cdf);
+
+    int threads = cfg->threads;
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > 64) threads = 64;
+    if ((size_t)threads > job.blocks) threads = job.blocks ? (int)job.blocks : 1;
+    job.nthreads = threads;
+
+    if (cfg->arrival == ARRIVAL_POISSON) {
+        gen_pass(&job, 0);
+        double start = 0.0;
+        for (size_t b = 0; b < job.blocks; ++b) {
+            double span = job.block_span_ms[b];
+            job.block_span_ms[b] = start;
+            start += span;
+        }
+        if (start >= 4294967295.0) {
+            // The last arrival would not fit in arrival_ms
+            free(job.items); free(job.block_span_ms);
+            return -1;
+        }
+    }
+    gen_pass(&job, 1);
+    free(job.block_span_ms);
+    out->items = job.items;
+    out->count = n;
+    return 0;
+}